@@ -0,0 +1,57 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.hpp"
+
+namespace
+{
+std::atomic<uint64_t> allocationsCount = 0;
+
+void* countedAllocation(std::size_t size)
+{
+    allocationsCount.fetch_add(1, std::memory_order_relaxed);
+    if(auto ptr = std::malloc(size > 0 ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+}
+
+namespace AVMuxer::Benchmarks
+{
+uint64_t getAllocationsCount()
+{
+    return allocationsCount.load(std::memory_order_relaxed);
+}
+}
+
+void* operator new(std::size_t size)
+{
+    return countedAllocation(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAllocation(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+namespace AVMuxer::Benchmarks
+{
+//Counts C++ heap allocations (operator new) made by whole benchmark binary; libav* allocations
+//(av_malloc) are not included
+uint64_t getAllocationsCount();
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "AllocationCounter.hpp"
+#include "Mp4Muxer.hpp"
+#include "SyntheticStreams.hpp"
+
+namespace AVMuxer::Benchmarks
+{
+namespace
+{
+constexpr unsigned   FPS = 30;
+constexpr unsigned   SESSION_SECONDS = 10;
+constexpr unsigned   VIDEO_FRAMES_COUNT = FPS * SESSION_SECONDS;
+constexpr int        AUDIO_SAMPLE_RATE = 48000;
+constexpr unsigned   AUDIO_FRAMES_COUNT = SESSION_SECONDS * AUDIO_SAMPLE_RATE / Synthetic::AAC_SAMPLES_PER_FRAME;
+constexpr size_t     OUTPUT_BUFFER_SIZE = 1 << 16;
+constexpr AVRational FRAMERATE = {FPS, 1};
+
+const ByteVector& getVideoStream()
+{
+    static const auto stream = Synthetic::generateH264Stream(VIDEO_FRAMES_COUNT);
+    return stream;
+}
+
+const ByteVector& getAudioStream()
+{
+    static const auto stream = Synthetic::generateAdtsStream(AUDIO_FRAMES_COUNT, Synthetic::SyntheticAudioSettings { .sampleRate = AUDIO_SAMPLE_RATE });
+    return stream;
+}
+
+//View of input's part, usable as muxer's input container
+struct InputBatch
+{
+    const uint8_t* begin;
+    size_t         length;
+
+    const uint8_t* data() const { return begin; }
+    size_t size() const { return length; }
+};
+
+InputBatch getBatch(const ByteVector& input, size_t offset, size_t batchSize)
+{
+    offset = std::min(offset, input.size());
+    return InputBatch { input.data() + offset, std::min(batchSize, input.size() - offset) };
+}
+
+void setSessionCounters(benchmark::State& state, size_t inputSize, unsigned framesCount, uint64_t allocationsCount)
+{
+    auto framesTotal = static_cast<double>(state.iterations()) * framesCount;
+    state.SetBytesProcessed(state.iterations() * inputSize);
+    state.counters["frames"] = benchmark::Counter(framesTotal, benchmark::Counter::kIsRate);
+    state.counters["allocs/frame"] = benchmark::Counter(allocationsCount / framesTotal);
+}
+}
+
+//Whole video stream is muxed in batches of given size; muxed data is drained after every batch
+static void BM_MuxMediaData(benchmark::State& state)
+{
+    const auto& input = getVideoStream();
+    size_t batchSize = state.range(0);
+    ByteVector output(OUTPUT_BUFFER_SIZE);
+    uint64_t allocationsCount = 0;
+    std::unique_ptr<VideoOnlyMp4Muxer> muxer;
+    for(auto _ : state)
+    {
+        state.PauseTiming();
+        muxer = std::make_unique<VideoOnlyMp4Muxer>(FRAMERATE);
+        auto allocationsAtStart = getAllocationsCount();
+        state.ResumeTiming();
+
+        for(size_t offset = 0; offset < input.size(); offset += batchSize)
+        {
+            muxer->muxVideoData(getBatch(input, offset, batchSize));
+            while(muxer->readMuxedData(output) > 0)
+                ;
+        }
+        muxer->flush();
+        while(muxer->readMuxedData(output) > 0)
+            ;
+
+        allocationsCount += getAllocationsCount() - allocationsAtStart;
+    }
+
+    setSessionCounters(state, input.size(), VIDEO_FRAMES_COUNT, allocationsCount);
+}
+BENCHMARK(BM_MuxMediaData)->RangeMultiplier(4)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+
+//Retrieving data of whole muxed session at once
+static void BM_GetMuxedData(benchmark::State& state)
+{
+    const auto& input = getVideoStream();
+    size_t outputSize = 0;
+    std::unique_ptr<VideoOnlyMp4Muxer> muxer;
+    for(auto _ : state)
+    {
+        state.PauseTiming();
+        muxer = std::make_unique<VideoOnlyMp4Muxer>(FRAMERATE);
+        muxer->muxVideoData(input);
+        muxer->flush();
+        state.ResumeTiming();
+
+        auto muxedData = muxer->getMuxedData();
+        outputSize += muxedData.size();
+        benchmark::DoNotOptimize(muxedData);
+    }
+
+    state.SetBytesProcessed(outputSize);
+}
+BENCHMARK(BM_GetMuxedData)->Unit(benchmark::kMicrosecond);
+
+//Audio and video session, fed alternately as if they were coming in real time, drained into caller's buffer
+static void BM_AudioVideoSession(benchmark::State& state)
+{
+    const auto& video = getVideoStream();
+    const auto& audio = getAudioStream();
+    size_t videoBatchSize = state.range(0);
+    size_t audioBatchSize = videoBatchSize * audio.size() / video.size() + 1;
+    ByteVector output(OUTPUT_BUFFER_SIZE);
+    uint64_t allocationsCount = 0;
+    std::unique_ptr<AudioVideoMp4Muxer> muxer;
+    for(auto _ : state)
+    {
+        state.PauseTiming();
+        muxer = std::make_unique<AudioVideoMp4Muxer>(FRAMERATE);
+        auto allocationsAtStart = getAllocationsCount();
+        state.ResumeTiming();
+
+        for(size_t videoOffset = 0, audioOffset = 0; videoOffset < video.size() || audioOffset < audio.size();
+            videoOffset += videoBatchSize, audioOffset += audioBatchSize)
+        {
+            muxer->muxVideoData(getBatch(video, videoOffset, videoBatchSize));
+            muxer->muxAudioData(getBatch(audio, audioOffset, audioBatchSize));
+            while(muxer->readMuxedData(output) > 0)
+                ;
+        }
+        muxer->flush();
+        while(muxer->readMuxedData(output) > 0)
+            ;
+
+        allocationsCount += getAllocationsCount() - allocationsAtStart;
+    }
+
+    setSessionCounters(state, video.size() + audio.size(), VIDEO_FRAMES_COUNT + AUDIO_FRAMES_COUNT, allocationsCount);
+}
+BENCHMARK(BM_AudioVideoSession)->RangeMultiplier(4)->Range(1 << 14, 1 << 18)->Unit(benchmark::kMillisecond);
+}
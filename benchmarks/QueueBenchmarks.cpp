@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+
+#include "ChunkedByteQueue.hpp"
+#include "MediaDataQueue.hpp"
+#include "OutputSink.hpp"
+
+namespace AVMuxer::Benchmarks
+{
+namespace
+{
+constexpr size_t BATCHES_PER_ITERATION = 64;
+}
+
+//Input side of MediaStreamContext::fillBuffer() - data is appended, read by demuxer and discarded
+static void BM_MediaDataQueueAppendReadDiscard(benchmark::State& state)
+{
+    ByteVector batch(state.range(0), 1);
+    ByteVector readBuffer(4096);
+    MediaDataQueue queue;
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i < BATCHES_PER_ITERATION; ++i)
+            queue.append(ByteArray(batch.data(), batch.size()));
+
+        while(queue.read(readBuffer.data(), readBuffer.size()) > 0)
+            ;
+        queue.discardReadData();
+    }
+
+    state.SetBytesProcessed(state.iterations() * BATCHES_PER_ITERATION * batch.size());
+}
+BENCHMARK(BM_MediaDataQueueAppendReadDiscard)->RangeMultiplier(4)->Range(1 << 10, 1 << 18);
+
+//Output side of getMuxedData() - muxer writes AVIO-buffer-sized pieces, which are then taken at once
+static void BM_ChunkedBufferSinkWriteAndTake(benchmark::State& state)
+{
+    ByteVector piece(4096, 1);
+    ChunkedBufferSink sink;
+    for(auto _ : state)
+    {
+        for(int64_t written = 0; written < state.range(0); written += piece.size())
+            sink.write(piece.data(), piece.size());
+
+        benchmark::DoNotOptimize(sink.takeData());
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ChunkedBufferSinkWriteAndTake)->RangeMultiplier(4)->Range(1 << 14, 1 << 22);
+
+//Same as above, but drained into caller's buffer with readMuxedData()
+static void BM_ChunkedBufferSinkWriteAndRead(benchmark::State& state)
+{
+    ByteVector piece(4096, 1);
+    ByteVector output(1 << 16);
+    ChunkedBufferSink sink;
+    for(auto _ : state)
+    {
+        for(int64_t written = 0; written < state.range(0); written += piece.size())
+            sink.write(piece.data(), piece.size());
+
+        while(sink.read(output.data(), output.size()) > 0)
+            benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ChunkedBufferSinkWriteAndRead)->RangeMultiplier(4)->Range(1 << 14, 1 << 22);
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "MediaContainerContext.hpp"
+#include "SyntheticStreams.hpp"
+#include "utils.hpp"
+
+namespace AVMuxer::Benchmarks
+{
+namespace
+{
+constexpr unsigned FRAMES_COUNT = 300;
+constexpr AVRational FRAMERATE = {30, 1};
+
+const ByteVector& getVideoStream()
+{
+    static const auto stream = Synthetic::generateH264Stream(FRAMES_COUNT);
+    return stream;
+}
+}
+
+static void BM_FillBuffer(benchmark::State& state)
+{
+    const auto& input = getVideoStream();
+    size_t batchSize = state.range(0);
+    std::unique_ptr<MediaContainerContext> container;
+    for(auto _ : state)
+    {
+        //Previous container (with its buffered data) is released here as well
+        state.PauseTiming();
+        container = std::make_unique<MediaContainerContext>("mp4");
+        auto stream = container->createStream(FRAMERATE);
+        state.ResumeTiming();
+
+        for(size_t offset = 0; offset < input.size(); offset += batchSize)
+            stream->fillBuffer(ByteArray(input.data() + offset, std::min(batchSize, input.size() - offset)));
+    }
+
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_FillBuffer)->RangeMultiplier(4)->Range(1 << 12, 1 << 20);
+
+//Probing is done outside of measured time - only demuxing of already identified stream is measured
+static void BM_GetNextFrame(benchmark::State& state)
+{
+    const auto& input = getVideoStream();
+    int64_t framesCount = 0;
+    std::unique_ptr<MediaContainerContext> container;
+    for(auto _ : state)
+    {
+        state.PauseTiming();
+        container = std::make_unique<MediaContainerContext>("mp4");
+        auto stream = container->createStream(FRAMERATE);
+        stream->fillBuffer(ByteArray(input.data(), input.size()));
+        if(!stream->initializeFormat())
+        {
+            state.SkipWithError("Couldn't identify synthetic stream");
+            break;
+        }
+        state.ResumeTiming();
+
+        for(auto packet = stream->getNextFrame(); isPacketValid(packet); packet = stream->getNextFrame())
+        {
+            ++framesCount;
+            av_packet_unref(&packet);
+        }
+    }
+
+    state.SetItemsProcessed(framesCount);
+    state.counters["frames"] = benchmark::Counter(framesCount, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_GetNextFrame)->Unit(benchmark::kMillisecond);
+}
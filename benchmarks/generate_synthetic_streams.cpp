@@ -0,0 +1,44 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "SyntheticStreams.hpp"
+
+namespace
+{
+bool writeFile(const char* path, const AVMuxer::ByteVector& data)
+{
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+}
+
+//Writes synthetic streams to files, ie. for blackbox tests
+int main(int argc, char** argv)
+{
+    if(argc < 4)
+    {
+        std::cout << "Usage: generate_synthetic_streams <output .h264 file path> <output .aac file path> <duration in seconds> [fps]" << std::endl;
+        return 1;
+    }
+
+    int seconds = std::atoi(argv[3]);
+    int fps = argc > 4 ? std::atoi(argv[4]) : 30;
+    if(seconds <= 0 || fps <= 0)
+    {
+        std::cout << "Duration and fps have to be positive" << std::endl;
+        return 1;
+    }
+
+    AVMuxer::Synthetic::SyntheticAudioSettings audioSettings;
+    auto video = AVMuxer::Synthetic::generateH264Stream(seconds * fps);
+    auto audio = AVMuxer::Synthetic::generateAdtsStream(seconds * audioSettings.sampleRate / AVMuxer::Synthetic::AAC_SAMPLES_PER_FRAME, audioSettings);
+    if(!writeFile(argv[1], video) || !writeFile(argv[2], audio))
+    {
+        std::cout << "Could not write output files" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
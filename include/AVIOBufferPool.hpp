@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace AVMuxer
+{
+//Input buffers are the ones demuxers read buffered media data through, output ones gather muxed data before it's passed to sink
+enum class IoBufferRole { INPUT, OUTPUT };
+
+//Size of I/O buffers created from now on (rounded up to whole pages, 4 KB by default) - bigger output buffer means
+//fewer, larger sink writes (ie. 64 KB for throughput), smaller one lets muxed data reach sink sooner
+void setDefaultIoBufferSize(IoBufferRole role, size_t size);
+
+size_t getDefaultIoBufferSize(IoBufferRole role);
+
+//Buffers for AVIO contexts, shared by all muxers - they're returned here when stream is re-probed or muxer is destroyed,
+//so starting sessions and retrying probes reuse them instead of going to allocator each time
+class AVIOBufferPool
+{
+    public:
+        static AVIOBufferPool& getInstance();
+
+        AVIOBufferPool(const AVIOBufferPool&) = delete;
+        AVIOBufferPool(AVIOBufferPool&&) = delete;
+
+        //Buffer is allocated with av_malloc(), so FFmpeg may free or reallocate it (ie. when it resizes I/O buffer);
+        //throws MuxerException if allocation fails
+        uint8_t* acquire(size_t size);
+        void     release(uint8_t* buffer, size_t size);
+
+        size_t getPooledSize() const;
+
+    private:
+        mutable std::mutex                                mutex;
+        std::unordered_map<size_t, std::vector<uint8_t*>> freeBuffers;
+        size_t                                            pooledSize = 0;
+
+        AVIOBufferPool() = default;
+};
+}
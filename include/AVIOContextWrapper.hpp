@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstddef>
+
+#include "AVIOBufferPool.hpp"
+
 extern "C"
 {
     #include <libavformat/avio.h>
@@ -8,29 +12,58 @@ extern "C"
 namespace AVMuxer
 {
 using IoProcedurePtr = int (void*, uint8_t*, int);
+using SeekProcedurePtr = int64_t (void*, int64_t, int);
+
+//Kept by wrapper as reference (has to outlive it), so wrapper stays small
+struct IoProcedures
+{
+    IoProcedurePtr*   readProc;
+    IoProcedurePtr*   writeProc;
+    SeekProcedurePtr* seekProc;
+};
 
+//AVIO context and its buffer (taken from AVIOBufferPool) are created only when context is first used
 class AVIOContextWrapper
 {
     public:
-        AVIOContextWrapper(void* applicationData, IoProcedurePtr readProc, IoProcedurePtr writeProc);
+        AVIOContextWrapper(void* applicationData, const IoProcedures& ioProcedures);
         ~AVIOContextWrapper();
 
-        operator AVIOContext*() const
+        operator AVIOContext*()
         {
-            return context;
+            return get();
         }
 
         AVIOContext* operator->()
         {
-            return context;
+            return get();
         }
 
+        //Buffer is returned to the pool, new one is taken once context is used again
         void reset();
-    
+
+        //Applies to buffer taken next time (0 means default size for wrapper's role)
+        void setBufferSize(size_t size);
+
+        bool isInitialized() const
+        {
+            return context != nullptr;
+        }
+
     private:
-        AVIOContext* context;
+        AVIOContext*        context;
+        void*               appData;
+        const IoProcedures* procedures;
+        size_t              requestedBufferSize;
+
+        AVIOContext* get()
+        {
+            if(context == nullptr)
+                initialize();
+            return context;
+        }
 
-        void initialize(void* applicationData, IoProcedurePtr readProc, IoProcedurePtr writeProc);
+        void initialize();
         void deinitialize();
 };
 }
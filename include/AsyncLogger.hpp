@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Logger.hpp"
+#include "utils.hpp"
+
+namespace AVMuxer
+{
+//Passes messages to wrapped logger on its own thread, so muxing threads never wait for slow logger.
+//Can be shared by any number of muxers and threads - messages are handed off through lock-free ring buffer,
+//which reuses its slots' memory; when it's full, messages are dropped (and counted)
+class AsyncLogger : public ILogger
+{
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+        explicit AsyncLogger(std::shared_ptr<ILogger> targetLogger, size_t minCapacity = DEFAULT_CAPACITY);
+        AsyncLogger(const AsyncLogger&) = delete;
+        AsyncLogger(AsyncLogger&&) = delete;
+        //Messages logged so far are still delivered
+        ~AsyncLogger() override;
+
+        void logAVMuxerMessage(const std::string& msg, LogLevel level) override;
+
+        uint64_t getDroppedCount() const
+        {
+            return droppedCount.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Slot;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> writeIndex;
+        alignas(CACHE_LINE_SIZE) size_t              readIndex;
+        std::atomic<uint64_t>                        droppedCount;
+        const size_t                                 capacity;
+        std::unique_ptr<Slot[]>                      slots;
+        std::shared_ptr<ILogger>                     target;
+        std::mutex                                   mutex;
+        std::condition_variable                      wakeUpCondition;
+        bool                                         isStopping;
+        std::atomic<bool>                            isWorkerWaiting;
+        //Started at the end of constructor's body, once slots' sequences are set
+        std::thread                                  worker;
+
+        bool hasPendingMessage() const;
+        void deliverPendingMessages();
+        void run();
+};
+}
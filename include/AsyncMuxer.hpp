@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ConcurrentMuxer.hpp"
+
+namespace AVMuxer
+{
+//Muxer running whole probe/demux/interleave/write pipeline on its own worker thread - producers only pay for
+//enqueuing input. Muxed data is delivered from worker thread through output sink passed to the constructor
+//(ie. CallbackSink), so a sink that pushes data out has to be given - there's no default one.
+//If muxing fails, worker stops processing input, pushMediaData() starts returning false and getError() tells why
+template <unsigned StreamsCount>
+class AsyncMuxer : protected ConcurrentMuxer<StreamsCount>
+{
+    using Base = ConcurrentMuxer<StreamsCount>;
+
+    public:
+        AsyncMuxer(const char* formatName, AVRational framerate, OutputSinkSharedPtr outputSink)
+            : Base(formatName, framerate, requireSink(outputSink))
+        {}
+
+        template <long unsigned VideoStreamsCount>
+        AsyncMuxer(const char* formatName, const std::array<AVRational, VideoStreamsCount>& framerates, OutputSinkSharedPtr outputSink)
+            : Base(formatName, framerates, requireSink(outputSink))
+        {}
+
+        AsyncMuxer(const char* formatName, AVRational framerate, const std::array<StreamProbeHints, StreamsCount>& probeHints,
+                   OutputSinkSharedPtr outputSink)
+            : Base(formatName, framerate, probeHints, requireSink(outputSink))
+        {}
+
+        template <long unsigned VideoStreamsCount>
+        AsyncMuxer(const char* formatName, const std::array<AVRational, VideoStreamsCount>& framerates,
+                   const std::array<StreamProbeHints, StreamsCount>& probeHints, OutputSinkSharedPtr outputSink)
+            : Base(formatName, framerates, probeHints, requireSink(outputSink))
+        {}
+
+        using Base::getMetrics;
+        using Base::getStreamsCount;
+        using Base::STREAMS_COUNT;
+
+        //Configuration - these have to be called before any input is pushed; buffer limits' watermark callbacks
+        //and stall/spill handling are then run on worker thread
+        using Base::setContainerOptions;
+        using Base::addOutput;
+        using Base::setBufferLimits;
+        using Base::setStarvationTimeout;
+        using Base::setCodecParameters;
+        using Base::setMaxPooledInputBufferSize;
+        using Base::setInputBufferSpilling;
+
+        ~AsyncMuxer()
+        {
+            {
+                std::lock_guard lock(mutex);
+                isStopping = true;
+            }
+            wakeUpCondition.notify_one();
+            worker.join();
+        }
+
+        template <unsigned StreamNumber, class ContainerT>
+        bool pushMediaData(const ContainerT& inputData)
+        {
+            if(isFailed.load(std::memory_order_relaxed) || !Base::template pushMediaData<StreamNumber>(inputData))
+                return false;
+
+            wakeUpWorker();
+            return true;
+        }
+
+        //Already framed packet for stream set up with setCodecParameters() (see Muxer::muxPacket()); data is copied
+        template <unsigned StreamNumber>
+        bool pushPacket(const uint8_t* data, size_t size, int64_t pts, int64_t dts, bool isKeyframe, int64_t duration = 0)
+        {
+            if(isFailed.load(std::memory_order_relaxed) || !Base::template pushPacket<StreamNumber>(data, size, pts, dts, isKeyframe, duration))
+                return false;
+
+            wakeUpWorker();
+            return true;
+        }
+
+        //Stream's input is finished by worker, after data pushed before is processed (see Muxer::finishInput())
+        template <unsigned StreamNumber>
+        bool finishInput()
+        {
+            if(isFailed.load(std::memory_order_relaxed) || !Base::template pushEndOfInput<StreamNumber>())
+                return false;
+
+            wakeUpWorker();
+            return true;
+        }
+
+        //Future is ready once all data pushed so far is processed and whatever can be flushed is written
+        std::future<void> flush()
+        {
+            return requestFlush(FlushAction::NONE);
+        }
+
+        //Same as flush(), but current media segment is then ended (see BaseMuxer::cutSegment())
+        std::future<void> cutSegment()
+        {
+            return requestFlush(FlushAction::CUT_SEGMENT);
+        }
+
+        //Same as flush(), but muxing is then ended and container's trailer is written (see BaseMuxer::finish());
+        //call it once all streams' input is finished - input pushed afterwards makes muxing fail
+        std::future<void> finish()
+        {
+            return requestFlush(FlushAction::FINISH);
+        }
+
+        std::exception_ptr getError()
+        {
+            std::lock_guard lock(mutex);
+            return error;
+        }
+
+        //Logger is swapped by worker thread, before it processes any more input
+        void setLogger(std::shared_ptr<ILogger> muxerLogger)
+        {
+            {
+                std::lock_guard lock(mutex);
+                pendingLogger = std::move(muxerLogger);
+                isLoggerChanged = true;
+            }
+            wakeUpCondition.notify_one();
+        }
+
+    private:
+        //Ordered, so stronger one wins when requests are handled in the same round - finishing also closes segment
+        enum class FlushAction { NONE, CUT_SEGMENT, FINISH };
+
+        std::mutex                      mutex;
+        std::condition_variable         wakeUpCondition;
+        std::vector<std::promise<void>> flushRequests;
+        std::exception_ptr              error;
+        std::shared_ptr<ILogger>        pendingLogger;
+        bool                            isLoggerChanged = false;
+        FlushAction                     pendingFlushAction = FlushAction::NONE;
+        bool                            isStopping = false;
+        std::atomic<bool>               isFailed = false;
+        std::atomic<bool>               isWorkerWaiting = false;
+        //Declared last, so worker starts once everything else is constructed
+        std::thread                     worker { &AsyncMuxer::run, this };
+
+        //Checked before base is constructed, so worker thread is never started for muxer without sink
+        static OutputSinkSharedPtr requireSink(OutputSinkSharedPtr outputSink)
+        {
+            if(!outputSink)
+                throw std::invalid_argument("AsyncMuxer needs output sink - muxed data can't be retrieved from its worker");
+            return outputSink;
+        }
+
+        std::future<void> requestFlush(FlushAction action)
+        {
+            std::promise<void> promise;
+            auto result = promise.get_future();
+            {
+                std::lock_guard lock(mutex);
+                if(error)
+                    promise.set_exception(error);
+                else
+                {
+                    flushRequests.push_back(std::move(promise));
+                    pendingFlushAction = std::max(pendingFlushAction, action);
+                }
+            }
+            wakeUpCondition.notify_one();
+            return result;
+        }
+
+        void wakeUpWorker()
+        {
+            //Pairs with the fence in waitForWork() - either worker sees pushed input, or producer sees it's waiting
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(!isWorkerWaiting.load(std::memory_order_relaxed))
+                return;
+
+            std::lock_guard lock(mutex);
+            wakeUpCondition.notify_one();
+        }
+
+        //Returns true if muxer is being destroyed
+        bool waitForWork(std::vector<std::promise<void>>& requests, FlushAction& flushAction)
+        {
+            std::unique_lock lock(mutex);
+            isWorkerWaiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wakeUpCondition.wait(lock, [this]
+            {
+                return isStopping || isLoggerChanged || !flushRequests.empty() || (!error && Base::hasQueuedInput());
+            });
+            isWorkerWaiting.store(false, std::memory_order_relaxed);
+            if(isLoggerChanged)
+            {
+                Base::setLogger(std::move(pendingLogger));
+                isLoggerChanged = false;
+            }
+            requests.swap(flushRequests);
+            flushAction = std::exchange(pendingFlushAction, FlushAction::NONE);
+            return isStopping;
+        }
+
+        void run()
+        {
+            std::vector<std::promise<void>> requests;
+            auto flushAction = FlushAction::NONE;
+            for(bool isLastRound = false; !isLastRound;)
+            {
+                isLastRound = waitForWork(requests, flushAction);
+                try
+                {
+                    if(!isFailed.load(std::memory_order_relaxed))
+                    {
+                        Base::processQueuedData();
+                        if(!requests.empty() || isLastRound)
+                            Base::flush();
+                        if(flushAction == FlushAction::CUT_SEGMENT)
+                            Base::cutSegment();
+                        else if(flushAction == FlushAction::FINISH)
+                            Base::finish();
+                    }
+                }
+                catch(...)
+                {
+                    auto loggerScope = Base::makeLoggerScope();
+                    std::lock_guard lock(mutex);
+                    error = std::current_exception();
+                    isFailed.store(true, std::memory_order_relaxed);
+                    log(LogLevel::ERROR, "AsyncMuxer - muxing failed on worker thread, input is no longer processed");
+                }
+
+                std::lock_guard lock(mutex);
+                for(auto& request : requests)
+                {
+                    if(error)
+                        request.set_exception(error);
+                    else
+                        request.set_value();
+                }
+                requests.clear();
+            }
+        }
+};
+}
@@ -1,36 +1,141 @@
 #pragma once
 
+#include <chrono>
+
+#include "BufferLimits.hpp"
 #include "DataStructures.hpp"
+#include "Metrics.hpp"
 #include "MediaStreamWrapper.hpp"
 #include "MediaContainerWrapper.hpp"
+#include "OutputSink.hpp"
+#include "utils.hpp"
 
 namespace AVMuxer
 {
 class BaseMuxer
 {
     public:
-        BaseMuxer(const char* formatName);
+        BaseMuxer(const char* formatName, OutputSinkSharedPtr outputSink = nullptr);
         BaseMuxer(const BaseMuxer&) = delete;
         BaseMuxer(BaseMuxer&&) = delete;
         virtual ~BaseMuxer() = default;
 
         ByteVector getMuxedData();
+        size_t     readMuxedData(uint8_t* dst, size_t capacity);
+
+        template <class ContainerT>
+        size_t readMuxedData(ContainerT& output)
+        {
+            return readMuxedData(output.data(), output.size());
+        }
+
+        size_t getMuxedDataSize() const
+        {
+            return containerCtxt->getMuxedDataSize();
+        }
 
         bool hasMuxedData()
         {
             return isMuxedDataAvailable;
         }
+
+        //These have to be called before any data is muxed
+        void setContainerOptions(const ContainerOptions& options);
+        //Muxes same streams into container of another format as well - data is demuxed only once for all of them;
+        //additional output's muxed data goes only to its own sink
+        void addOutput(const char* formatName, OutputSinkSharedPtr outputSink, const ContainerOptions& options = {});
+
+        //Has to be called before muxing starts; data buffered by streams while they're probed counts against limits
+        void setBufferLimits(BufferLimits limits);
+
+        //For live sources - stream which doesn't receive any data for given time is left out of interleaving,
+        //so other streams aren't held back by it, and rejoins once its data arrives again (0 turns it off);
+        //applies once muxing has started
+        void setStarvationTimeout(std::chrono::milliseconds timeout)
+        {
+            starvationTimeout = timeout;
+        }
+
+        //Input data buffered by all streams; it's tracked only when buffer limits are set
+        size_t getBufferedInputSize() const
+        {
+            return bufferedInputSize;
+        }
+
+        //Ends current media segment without waiting for next keyframe (ie. at the end of input)
+        bool cutSegment();
+
+        //Ends muxing - packets still waiting for interleaving are written, current segment is closed and container's
+        //trailer is written, for additional outputs as well; call it once all streams are finished and flushed.
+        //Nothing can be muxed afterwards
+        bool finish();
+
+        //Can be polled from any thread while muxing is in progress
+        MuxerMetrics getMetrics() const;
+
+        //Messages logged while this muxer is working go to given logger instead of global one
+        void setLogger(std::shared_ptr<ILogger> muxerLogger)
+        {
+            logger = std::move(muxerLogger);
+        }
     
     protected:
         virtual void updateStreamRelativeTimeAhead(MediaStreamWrapper& mediaCtxt, int64_t diff) = 0;
         virtual bool shouldStreamBeLimited(MediaStreamWrapper& mediaCtxt) = 0;
+        virtual std::vector<StreamMetrics> getStreamsMetrics() const = 0;
+        virtual size_t getStreamsBufferedSize() const = 0;
+        //Returns true if any stream has just been left out of interleaving
+        virtual bool excludeStalledStreams() = 0;
+        virtual void rejoinStream(MediaStreamWrapper& mediaCtxt) = 0;
+        //Finished stream with nothing more to demux mustn't hold other streams back
+        virtual void leaveInterleaving(MediaStreamWrapper& mediaCtxt) = 0;
         int muxMediaData(MediaStreamWrapper& mediaCtxt, const ByteArray& inputData);
+        int muxMediaData(MediaStreamWrapper& mediaCtxt, const SharedByteArray& inputData);
+        int muxPacket(MediaStreamWrapper& mediaCtxt, const EncodedPacket& packet);
+        int finishInput(MediaStreamWrapper& mediaCtxt);
+
+        //Once it's true, container's header is written and no streams can be added
+        bool isMuxingStarted() const
+        {
+            return isContainerInitialized;
+        }
+
+        //Tells if given input for given stream should be refused according to buffer limits
+        bool wouldExceedBudget(MediaStreamWrapper& mediaCtxt, size_t inputSize);
+
+        bool isStreamStarved(const MediaStreamWrapper& mediaCtxt, std::chrono::steady_clock::time_point now) const;
+
+        //Clock which starvation is measured with; tests replace it, so they don't have to wait for timeouts
+        virtual std::chrono::steady_clock::time_point getCurrentTime() const
+        {
+            return std::chrono::steady_clock::now();
+        }
+
+        LoggerScope makeLoggerScope() const
+        {
+            return LoggerScope(logger.get());
+        }
 
         std::shared_ptr<MediaContainerWrapper> containerCtxt;
         int64_t timeAheadInCommonTimebaseLimit;
     
     private:
+        int muxBufferedData(MediaStreamWrapper& mediaCtxt);
+        bool isStreamHeldBack(MediaStreamWrapper& mediaCtxt);
+        void trackStarvation(MediaStreamWrapper& mediaCtxt, size_t inputSize);
+        void throwIfInputFinished(const MediaStreamWrapper& mediaCtxt, size_t inputSize) const;
+        size_t getStreamBufferedSize(MediaStreamWrapper& mediaCtxt) const;
+        void updateBufferedInputSize(MediaStreamWrapper& mediaCtxt, size_t previousStreamBufferedSize);
+
         bool isMuxedDataAvailable;
         bool isContainerInitialized;
+        MetricCounter<uint64_t> packetsMuxed;
+        std::shared_ptr<ILogger> logger;
+        BufferLimits bufferLimits;
+        bool isBufferingTracked;
+        bool isAboveHighWatermark;
+        size_t bufferedInputSize;
+        std::chrono::milliseconds starvationTimeout;
+        std::chrono::steady_clock::time_point firstInputTime;
 };
 }
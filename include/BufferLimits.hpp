@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace AVMuxer
+{
+//Limits of input data kept in streams' buffers until it's demuxed, in bytes (0 means no limit).
+//Budgets are enforced by tryMuxMediaData() for every stream, also while muxer waits for others to start;
+//if stream which others wait for is refused, muxer budget is too small or that stream should be finished
+struct BufferLimits
+{
+    size_t streamBudget = 0;
+    size_t muxerBudget = 0;
+    //Callbacks are called on muxing thread once data buffered by all streams reaches high watermark,
+    //and then once it drops back to low watermark (which has to be below high one)
+    size_t                highWatermark = 0;
+    size_t                lowWatermark = 0;
+    std::function<void()> onHighWatermark;
+    std::function<void()> onLowWatermark;
+};
+
+enum class TryMuxResult { ACCEPTED, WOULD_EXCEED_BUDGET };
+}
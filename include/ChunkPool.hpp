@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace AVMuxer
+{
+//Keeps freed nodes of byte queues (linked through their `next` member) for reuse, but only up to given count,
+//so once queue reaches its working size it doesn't allocate, and memory is still given back after bursts of data
+template <class NodeT>
+class ChunkPool
+{
+    public:
+        ChunkPool(size_t maxPooledCount) : pooledNodes(nullptr), pooledCount(0), maxPooled(maxPooledCount)
+        {}
+
+        ChunkPool(const ChunkPool&) = delete;
+        ChunkPool(ChunkPool&&) = delete;
+
+        ~ChunkPool()
+        {
+            trim(0);
+        }
+
+        //Returned node's `next` is cleared, other members are left as they were
+        NodeT* acquire()
+        {
+            NodeT* node = pooledNodes;
+            if(node != nullptr)
+            {
+                pooledNodes = static_cast<NodeT*>(node->next);
+                --pooledCount;
+            }
+            else
+                node = new NodeT;
+
+            node->next = nullptr;
+            return node;
+        }
+
+        void release(NodeT* node)
+        {
+            if(pooledCount >= maxPooled)
+            {
+                delete node;
+                return;
+            }
+
+            node->next = pooledNodes;
+            pooledNodes = node;
+            ++pooledCount;
+        }
+
+        void setMaxPooledCount(size_t maxPooledCount)
+        {
+            maxPooled = maxPooledCount;
+            trim(maxPooled);
+        }
+
+        size_t getPooledCount() const
+        {
+            return pooledCount;
+        }
+
+    private:
+        NodeT* pooledNodes;
+        size_t pooledCount;
+        size_t maxPooled;
+
+        void trim(size_t count)
+        {
+            while(pooledCount > count)
+            {
+                delete std::exchange(pooledNodes, static_cast<NodeT*>(pooledNodes->next));
+                --pooledCount;
+            }
+        }
+};
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ChunkPool.hpp"
+#include "utils.hpp"
+
+namespace AVMuxer
+{
+//FIFO of bytes kept in fixed-size chunks; drained chunks are recycled, so once the queue
+//reaches its working size, appending and reading data doesn't allocate any memory
+class ChunkedByteQueue
+{
+    public:
+        static constexpr size_t CHUNK_SIZE = 16 * PAGE_SIZE;
+        static constexpr size_t DEFAULT_MAX_POOLED_CHUNKS = 16;
+
+        ChunkedByteQueue(size_t maxPooledChunksCount = DEFAULT_MAX_POOLED_CHUNKS);
+        ChunkedByteQueue(const ChunkedByteQueue&) = delete;
+        ChunkedByteQueue(ChunkedByteQueue&&) = delete;
+        ~ChunkedByteQueue();
+
+        void   append(const uint8_t* data, size_t dataSize);
+        size_t read(uint8_t* dst, size_t capacity);
+
+        size_t size() const
+        {
+            return queuedSize;
+        }
+
+        bool empty() const
+        {
+            return queuedSize == 0;
+        }
+
+    private:
+        struct Chunk
+        {
+            Chunk*  next;
+            size_t  begin;
+            size_t  end;
+            uint8_t data[CHUNK_SIZE];
+        };
+
+        Chunk*           head;
+        Chunk*           tail;
+        ChunkPool<Chunk> chunkPool;
+        size_t           queuedSize;
+
+        Chunk* acquireChunk();
+};
+}
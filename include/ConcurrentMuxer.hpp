@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <utility>
+
+#include "Muxer.hpp"
+#include "SpscQueue.hpp"
+
+namespace AVMuxer
+{
+//Muxer which streams can be fed from different threads (one producer thread per stream) without locking.
+//Input is only queued by producers; demuxing, interleaving and writing is done by single consumer thread
+//calling processQueuedData() - muxed data should also be retrieved from that thread (or pushed out with sink)
+template <unsigned StreamsCount>
+class ConcurrentMuxer : public Muxer<StreamsCount>
+{
+    using Base = Muxer<StreamsCount>;
+
+    public:
+        using Base::Base;
+
+        //Producer side; returns false without blocking if stream's queue is full
+        template <unsigned StreamNumber, class ContainerT>
+        bool pushMediaData(const ContainerT& inputData)
+        {
+            static_assert(StreamNumber < StreamsCount);
+            if(inputQueues[StreamNumber].isFull())
+                return false;
+
+            std::shared_ptr<uint8_t[]> buffer(new uint8_t[inputData.size()]);
+            std::copy_n(inputData.data(), inputData.size(), buffer.get());
+            return pushMediaData<StreamNumber>(SharedByteArray(buffer, inputData.size()));
+        }
+
+        template <unsigned StreamNumber>
+        bool pushMediaData(const SharedByteArray& inputData)
+        {
+            static_assert(StreamNumber < StreamsCount);
+            return inputQueues[StreamNumber].tryPush(QueuedInput { inputData.data, inputData.size, inputData.owner });
+        }
+
+        //Producer side counterpart of muxPacket() - packet's data is copied, as it's muxed later on consumer thread
+        template <unsigned StreamNumber>
+        bool pushPacket(const uint8_t* data, size_t size, int64_t pts, int64_t dts, bool isKeyframe, int64_t duration = 0)
+        {
+            static_assert(StreamNumber < StreamsCount);
+            if(inputQueues[StreamNumber].isFull())
+                return false;
+
+            std::shared_ptr<uint8_t[]> buffer(new uint8_t[size]);
+            std::copy_n(data, size, buffer.get());
+            return inputQueues[StreamNumber].tryPush(QueuedInput { buffer.get(), size, buffer, QueuedInput::Kind::PACKET,
+                                                                   pts, dts, duration, isKeyframe });
+        }
+
+        //Producer side counterpart of finishInput() - stream's input is finished once data queued before is processed
+        template <unsigned StreamNumber>
+        bool pushEndOfInput()
+        {
+            static_assert(StreamNumber < StreamsCount);
+            return inputQueues[StreamNumber].tryPush(QueuedInput { nullptr, 0, nullptr, QueuedInput::Kind::END_OF_INPUT });
+        }
+
+        //Consumer side; returns number of processed input buffers
+        int processQueuedData()
+        {
+            int processedCount = 0;
+            for(int roundCount = 1; roundCount > 0; processedCount += roundCount)
+                roundCount = processQueuesRound(std::make_index_sequence<StreamsCount>());
+
+            //Streams drained earlier in the round may have been held back by later ones
+            if(processedCount > 0)
+                Base::flush();
+            return processedCount;
+        }
+
+        bool hasQueuedInput() const
+        {
+            return std::any_of(inputQueues.begin(), inputQueues.end(), [](const auto& queue) { return !queue.empty(); });
+        }
+
+    private:
+        struct QueuedInput
+        {
+            enum class Kind { MEDIA_DATA, PACKET, END_OF_INPUT };
+
+            const uint8_t*              data = nullptr;
+            size_t                      size = 0;
+            std::shared_ptr<const void> owner;
+            Kind                        kind = Kind::MEDIA_DATA;
+            //Used only by packets
+            int64_t                     pts = 0;
+            int64_t                     dts = 0;
+            int64_t                     duration = 0;
+            bool                        isKeyframe = false;
+        };
+
+        std::array<SpscQueue<QueuedInput>, StreamsCount> inputQueues;
+
+        template <std::size_t... StreamsIndices>
+        int processQueuesRound(std::index_sequence<StreamsIndices...>)
+        {
+            return (processQueuedInput<StreamsIndices>() + ...);
+        }
+
+        template <unsigned StreamNumber>
+        int processQueuedInput()
+        {
+            QueuedInput input;
+            if(!inputQueues[StreamNumber].tryPop(input))
+                return 0;
+
+            switch(input.kind)
+            {
+                case QueuedInput::Kind::MEDIA_DATA:
+                    Base::template muxMediaData<StreamNumber>(SharedByteArray(input.data, input.size, std::move(input.owner)));
+                    break;
+                case QueuedInput::Kind::PACKET:
+                    Base::template muxPacket<StreamNumber>(input.data, input.size, input.pts, input.dts, input.isKeyframe, input.duration);
+                    break;
+                case QueuedInput::Kind::END_OF_INPUT:
+                    Base::template finishInput<StreamNumber>();
+                    break;
+            }
+            return 1;
+        }
+};
+}
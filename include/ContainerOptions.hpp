@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace AVMuxer
+{
+//Muxer-level settings; they have to be set before container's header is written
+struct ContainerOptions
+{
+    //Passed as they are to muxer (ie. {"movflags", "frag_keyframe+empty_moov"}); when movflags aren't given,
+    //fragmented MP4 flags suitable for streaming (or for segmenting, if it's enabled) are used for mp4.
+    //Segmented mp4 needs frag_custom in movflags, as fragments are cut along with segments and chunks
+    std::vector<std::pair<std::string, std::string>> formatOptions;
+
+    //Non-zero enables segmenting: init segment is emitted right after header, then media segments are cut
+    //at first video keyframe (or first stream's keyframe, if there's no video) after this duration (in AV_TIME_BASE units)
+    int64_t segmentDuration = 0;
+
+    //Non-zero enables low-latency mode: partial fragments (chunks) of this duration (in AV_TIME_BASE units) are cut
+    //within segments regardless of keyframes, and each of them is pushed out to the sink as soon as it's complete;
+    //it needs segmenting to be enabled as well
+    int64_t chunkDuration = 0;
+
+    //Overrides muxer's interleaving window (in AV_TIME_BASE units), which also bounds how far ahead
+    //of others any stream may get; in low-latency mode it defaults to chunk duration
+    int64_t maxInterleaveDelta = 0;
+
+    //Size of buffer muxed data is gathered in before it's written to sink (0 means default size for output buffers,
+    //see setDefaultIoBufferSize()); bigger one (ie. 64 KB) means fewer, larger writes, smaller one lower latency
+    size_t ioBufferSize = 0;
+};
+}
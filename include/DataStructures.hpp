@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace AVMuxer
@@ -30,4 +34,22 @@ struct ByteArray
     const uint8_t* const data;
     const size_t size;
 };
+
+//Data buffer handed over to muxer without copying it - owner is released once all the data has been demuxed
+struct SharedByteArray : ByteArray
+{
+    SharedByteArray(const uint8_t* const ptr, size_t dataSize, std::shared_ptr<const void> dataOwner)
+        : ByteArray(ptr, dataSize), owner(std::move(dataOwner))
+    {}
+
+    SharedByteArray(const uint8_t* const ptr, size_t dataSize, std::function<void()> releaseCallback)
+        : SharedByteArray(ptr, dataSize, std::shared_ptr<const void>(ptr, [releaseCallback](const void*) { releaseCallback(); }))
+    {}
+
+    SharedByteArray(const std::shared_ptr<const uint8_t[]>& buffer, size_t dataSize)
+        : SharedByteArray(buffer.get(), dataSize, std::shared_ptr<const void>(buffer))
+    {}
+
+    const std::shared_ptr<const void> owner;
+};
 }
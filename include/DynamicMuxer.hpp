@@ -0,0 +1,84 @@
+#pragma once
+
+#include <set>
+#include <vector>
+
+#include "BaseMuxer.hpp"
+#include "MediaStreamWrapper.hpp"
+
+namespace AVMuxer
+{
+//Muxer which streams are added at runtime (before any data is muxed) and addressed by index returned from addStream().
+//Streams' time ahead is kept as absolute value and ordered in a multiset, so interleaving bookkeeping
+//costs O(log n) per packet instead of rescanning all streams
+class DynamicMuxer : public BaseMuxer
+{
+    public:
+        DynamicMuxer(const char* formatName, OutputSinkSharedPtr outputSink = nullptr);
+
+        //Adds audio (or other non-video) stream, returns its index
+        unsigned addStream();
+        unsigned addStream(const StreamProbeHints& probeHints);
+
+        //Adds video stream, returns its index
+        unsigned addStream(AVRational framerate);
+        unsigned addStream(AVRational framerate, const StreamProbeHints& probeHints);
+
+        template <class ContainerT>
+        bool muxMediaData(unsigned streamIndex, const ContainerT& inputData)
+        {
+            BaseMuxer::muxMediaData(*streams.at(streamIndex), ByteArray { inputData.data(), inputData.size() });
+            return hasMuxedData();
+        }
+
+        bool muxMediaData(unsigned streamIndex, const SharedByteArray& inputData);
+
+        //Non-blocking variants of muxMediaData() - input is refused (and not buffered) if it would exceed buffer budgets
+        template <class ContainerT>
+        TryMuxResult tryMuxMediaData(unsigned streamIndex, const ContainerT& inputData)
+        {
+            if(wouldExceedBudget(*streams.at(streamIndex), inputData.size()))
+                return TryMuxResult::WOULD_EXCEED_BUDGET;
+
+            muxMediaData(streamIndex, inputData);
+            return TryMuxResult::ACCEPTED;
+        }
+
+        TryMuxResult tryMuxMediaData(unsigned streamIndex, const SharedByteArray& inputData);
+
+        //Tells that stream's input is over - see Muxer::finishInput()
+        bool finishInput(unsigned streamIndex);
+
+        void setCodecParameters(unsigned streamIndex, const CodecParameters& params);
+        bool muxPacket(unsigned streamIndex, const uint8_t* data, size_t size, int64_t pts, int64_t dts, bool isKeyframe, int64_t duration = 0);
+        //Limits memory each stream keeps for reuse once its input buffers are drained, not how much input is buffered
+        void setMaxPooledInputBufferSize(size_t maxPooledSize);
+        //Applies to streams added so far
+        void setInputBufferSpilling(size_t thresholdSize, const std::string& directory = {});
+        bool flush();
+
+        unsigned getStreamsCount() const
+        {
+            return streams.size();
+        }
+
+    protected:
+        void updateStreamRelativeTimeAhead(MediaStreamWrapper& mediaCtxt, int64_t diff) override;
+        bool shouldStreamBeLimited(MediaStreamWrapper& mediaCtxt) override;
+        //Streams can't be added while metrics are polled from other thread
+        std::vector<StreamMetrics> getStreamsMetrics() const override;
+        size_t getStreamsBufferedSize() const override;
+        //Stalled streams' time ahead is left out of the multiset
+        bool excludeStalledStreams() override;
+        void rejoinStream(MediaStreamWrapper& mediaCtxt) override;
+        void leaveInterleaving(MediaStreamWrapper& mediaCtxt) override;
+
+        std::vector<WrappedMediaStreamSharedPtr> streams;
+
+    private:
+        void throwIfMuxingStarted() const;
+        unsigned addCreatedStream(WrappedMediaStreamSharedPtr stream);
+
+        std::multiset<int64_t> streamsTimeAhead;
+};
+}
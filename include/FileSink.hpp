@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "OutputSink.hpp"
+#include "utils.hpp"
+
+namespace AVMuxer
+{
+enum class FsyncPolicy { NEVER, ON_CLOSE, EVERY_SEGMENT, EVERY_BATCH };
+
+struct FileSinkOptions
+{
+    //At least one page
+    size_t      batchSize = 256 * PAGE_SIZE;
+    //Submitting a batch blocks muxing thread (inside write(), closeSegment() or closeChunk()) while this much data
+    //is still waiting to be written, until writer thread catches up; use watermarks to slow input down before that
+    size_t      maxPendingSize = 64 * 256 * PAGE_SIZE;
+    FsyncPolicy fsyncPolicy = FsyncPolicy::ON_CLOSE;
+    //High watermark callback is called on muxing thread once data waiting to be written reaches it, and low watermark
+    //one on writer thread once that data drops back to low watermark (which has to be below high one; 0 disables both).
+    //Both are called under sink's lock, so they mustn't call back into the sink
+    size_t                highWatermark = 0;
+    size_t                lowWatermark = 0;
+    std::function<void()> onHighWatermark;
+    std::function<void()> onLowWatermark;
+};
+
+//Writes muxed data to file in batches, which are written with pwritev() on one of few background writer
+//threads shared by all file sinks (consecutive batches of the same file are written with single call), so disk writes
+//don't block muxing unless writer falls behind by more than maxPendingSize, and syncing one file holds back only files
+//sharing its writer thread. Write errors are reported by next write() and make muxing fail. Data is also submitted at
+//the end of each segment and chunk, so it gets to disk without waiting for batch to fill up
+class FileSink : public IOutputSink
+{
+    public:
+        //File is created or truncated; throws MuxerException if it can't be opened,
+        //and std::invalid_argument if low watermark isn't below high one
+        FileSink(const std::string& path, const FileSinkOptions& options = {});
+        FileSink(const FileSink&) = delete;
+        FileSink(FileSink&&) = delete;
+        //Waits until all data is written (and synced, unless fsync policy is NEVER)
+        ~FileSink() override;
+
+        int  write(const uint8_t* data, int size) override;
+        void closeSegment(const SegmentInfo& info) override;
+        void closeChunk(const SegmentInfo& info) override;
+
+        //Waits until all data written to sink so far is written to file; returns 0 or negative AVERROR code
+        int flush(bool shouldSync = false);
+
+        struct FileState;
+        struct Batch;
+
+    private:
+        FileSinkOptions            options;
+        std::shared_ptr<FileState> state;
+        std::unique_ptr<Batch>     currentBatch;
+        uint64_t                   fileOffset;
+
+        void submitBatch(bool shouldSync);
+};
+}
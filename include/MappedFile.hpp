@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "DataStructures.hpp"
+
+namespace AVMuxer
+{
+//Read-only memory mapping of whole input file (ie. elementary stream for batch remuxing), with sequential read-ahead.
+//Its parts are passed to muxer as SharedByteArray, so input is read straight from page cache instead of
+//being copied into intermediate buffers; pages of released parts are dropped from process' resident memory
+class MappedFile : public std::enable_shared_from_this<MappedFile>
+{
+    public:
+        //Throws MuxerException if file can't be opened or mapped
+        static std::shared_ptr<MappedFile> open(const std::string& path);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile(MappedFile&&) = delete;
+        ~MappedFile();
+
+        //Part of file (clamped to its end) that keeps mapping alive as long as it's referenced
+        SharedByteArray getData(size_t offset, size_t size) const;
+
+        SharedByteArray getData() const
+        {
+            return getData(0, fileSize);
+        }
+
+        size_t size() const
+        {
+            return fileSize;
+        }
+
+    private:
+        uint8_t* mapping;
+        size_t   fileSize;
+
+        MappedFile(uint8_t* fileMapping, size_t mappedSize);
+
+        void releasePages(size_t offset, size_t size) const;
+};
+}
@@ -3,7 +3,10 @@
 #include <memory>
 
 #include "AVIOContextWrapper.hpp"
+#include "ContainerOptions.hpp"
 #include "MediaStreamContext.hpp"
+#include "Metrics.hpp"
+#include "OutputSink.hpp"
 
 namespace AVMuxer
 {
@@ -14,7 +17,7 @@ class MediaContainerContext
     friend int muxCallback(void*, uint8_t*, int);
 
     public:
-        MediaContainerContext(const char* formatName);
+        MediaContainerContext(const char* formatName, OutputSinkSharedPtr sink = nullptr);
         ~MediaContainerContext();
         
         operator bool()
@@ -24,20 +27,63 @@ class MediaContainerContext
 
         MediaStreamSharedPtr createStream(AVRational framerate);
 
+        //Adds container of another format, which gets same packets as this one (sharing their data) - streams
+        //are demuxed only once for all outputs. Its muxed data goes only to given sink
+        void       addMirrorOutput(const char* formatName, OutputSinkSharedPtr sink, const ContainerOptions& mirrorOptions);
+
+        void       setOptions(const ContainerOptions& containerOptions);
         bool       muxFramePacket(AVPacket&& packet);
+        bool       cutSegment();
+        //Writes trailer, which writes packets still waiting for interleaving first, and closes current segment
+        //(of mirrors as well); trailer's data is part of last segment. Nothing can be muxed afterwards
+        bool       finish();
         ByteVector getMuxedData();
+        size_t     readMuxedData(uint8_t* dst, size_t capacity);
+
+        size_t getMuxedDataSize() const
+        {
+            return outputSink->getPendingDataSize();
+        }
 
         AVFormatContext* getFormatContext() const
         {
             return formatCtxt;
         }
+
+        //Safe to call from any thread
+        uint64_t getOutputBytesCount() const
+        {
+            return outputBytesCount.get();
+        }
         
     private:
-        ByteVector muxedMediaData;
+        OutputSinkSharedPtr outputSink;
         std::vector<MediaStreamSharedPtr> streamCtxts;
+        std::vector<std::unique_ptr<MediaContainerContext>> mirrors;
         AVFormatContext* formatCtxt;
         AVIOContextWrapper ioCtxt;
+        ContainerOptions options;
+        int segmentReferenceStream;
+        int64_t segmentStartTime;
+        int64_t segmentEndTime;
+        int64_t chunkStartTime;
+        unsigned segmentsCount;
+        unsigned chunksCount;
+        bool isFinished;
+        MetricCounter<uint64_t> outputBytesCount;
 
         bool writeHeaderIfNeeded();
+        void initializeAsMirrorOf(const AVFormatContext* sourceFormatCtxt);
+        void muxMirroredPacket(const AVPacket& packet, AVRational sourceTimebase);
+        bool isSegmentBoundary(const AVPacket& packet, int64_t packetTime) const;
+        bool isChunkBoundary(const AVPacket& packet, int64_t packetTime) const;
+        void flushFragment();
+        void closeChunk(int64_t endTime);
+        void closeSegment(int64_t endTime);
+
+        bool isFragmenting() const
+        {
+            return options.segmentDuration > 0;
+        }
 };
 }
@@ -11,7 +11,7 @@ using WrappedMediaStreamSharedPtr = std::shared_ptr<MediaStreamWrapper>;
 class MediaContainerWrapper
 {
     public:
-        MediaContainerWrapper(const char* format) : containerCtxt(format)
+        MediaContainerWrapper(const char* format, OutputSinkSharedPtr sink = nullptr) : containerCtxt(format, sink)
         {
         }
 
@@ -33,11 +33,31 @@ class MediaContainerWrapper
             return std::shared_ptr<MediaStreamWrapper>(ptr);
         }
 
+        virtual void addMirrorOutput(const char* formatName, OutputSinkSharedPtr sink, const ContainerOptions& options)
+        {
+            containerCtxt.addMirrorOutput(formatName, sink, options);
+        }
+
+        virtual void setOptions(const ContainerOptions& options)
+        {
+            containerCtxt.setOptions(options);
+        }
+
         virtual bool muxFramePacket(AVPacket&& packet)
         {
             return containerCtxt.muxFramePacket(std::move(packet));
         }
 
+        virtual bool cutSegment()
+        {
+            return containerCtxt.cutSegment();
+        }
+
+        virtual bool finish()
+        {
+            return containerCtxt.finish();
+        }
+
         virtual int64_t getMaxInterleaveDelta() const
         {
             return containerCtxt.getFormatContext()->max_interleave_delta;
@@ -48,6 +68,21 @@ class MediaContainerWrapper
             return containerCtxt.getMuxedData();
         }
 
+        virtual size_t readMuxedData(uint8_t* dst, size_t capacity)
+        {
+            return containerCtxt.readMuxedData(dst, capacity);
+        }
+
+        virtual size_t getMuxedDataSize() const
+        {
+            return containerCtxt.getMuxedDataSize();
+        }
+
+        uint64_t getOutputBytesCount() const
+        {
+            return containerCtxt.getOutputBytesCount();
+        }
+
     private:
         MediaContainerContext containerCtxt;
 };
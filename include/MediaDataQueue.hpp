@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ChunkPool.hpp"
+#include "DataStructures.hpp"
+#include "SpillFile.hpp"
+#include "utils.hpp"
+
+namespace AVMuxer
+{
+//Input media data queue made of segments - either fixed-size chunks that data is copied into,
+//or caller's buffers attached without copying. Appending costs only as much as copying new data.
+//Read data is kept (so reading can be rewound or moved to any position within kept data) until it's
+//explicitly discarded; positions are counted from the very first byte ever appended. Chunks freed that way
+//are pooled for reuse, but only up to given size (which doesn't limit queued data), so memory is given back after bursts of data.
+//Optionally, data appended while queue holds more than spill threshold goes to temporary file instead of memory
+class MediaDataQueue
+{
+    public:
+        static constexpr size_t CHUNK_SIZE = 16 * PAGE_SIZE;
+        static constexpr size_t DEFAULT_MAX_POOLED_SIZE = 16 * CHUNK_SIZE;
+        static constexpr size_t MAX_POOLED_SEGMENTS = 64;
+
+        MediaDataQueue(size_t maxPooledSize = DEFAULT_MAX_POOLED_SIZE);
+        MediaDataQueue(const MediaDataQueue&) = delete;
+        MediaDataQueue(MediaDataQueue&&) = delete;
+        ~MediaDataQueue();
+
+        void   append(const ByteArray& data);
+        void   attach(const SharedByteArray& data);
+        size_t read(uint8_t* dst, size_t capacity);
+        void   rewind();
+        bool   seek(uint64_t position);
+        void   discardUntil(uint64_t position);
+        void   setMaxPooledSize(size_t maxPooledSize);
+        //Threshold of 0 turns spilling off; file is created in given directory once it's needed
+        void   setSpilling(size_t thresholdSize, const std::string& directory = {});
+
+        void discardReadData()
+        {
+            discardUntil(getReadPosition());
+        }
+
+        uint64_t getReadPosition() const
+        {
+            return discardedSize + readSize;
+        }
+
+        uint64_t getStartPosition() const
+        {
+            return discardedSize;
+        }
+
+        size_t size() const
+        {
+            return queuedSize;
+        }
+
+        size_t unreadSize() const
+        {
+            return queuedSize - readSize;
+        }
+
+        bool empty() const
+        {
+            return queuedSize == 0;
+        }
+
+    private:
+        struct Segment
+        {
+            Segment*                    next;
+            const uint8_t*              data;
+            size_t                      begin;
+            size_t                      end;
+            std::shared_ptr<const void> owner;
+            //Spilled segment is a window of spill file, which data is appended to like to a chunk
+            bool                        isSpilled;
+            uint64_t                    spillOffset;
+
+            bool isAttached() const
+            {
+                return owner != nullptr;
+            }
+        };
+
+        struct Spilling
+        {
+            size_t                     threshold;
+            std::string                directory;
+            std::shared_ptr<SpillFile> file;
+        };
+
+        struct Chunk : Segment
+        {
+            uint8_t storage[CHUNK_SIZE];
+        };
+
+        Segment*           head;
+        Segment*           tail;
+        Segment*           readSegment;
+        size_t             readPos;
+        size_t             readSize;
+        size_t             queuedSize;
+        uint64_t           discardedSize;
+        ChunkPool<Chunk>   chunkPool;
+        ChunkPool<Segment> segmentPool;
+        //Kept out of line, so queue stays small when spilling isn't used
+        std::unique_ptr<Spilling> spilling;
+
+        size_t   appendToChunk(const uint8_t* src, size_t size);
+        size_t   spill(const uint8_t* src, size_t size);
+        void     pushBack(Segment* segment);
+        Chunk*   acquireChunk();
+        Segment* acquireSegment();
+        void     release(Segment* segment);
+};
+}
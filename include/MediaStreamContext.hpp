@@ -1,10 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <vector>
 
 #include "AVIOContextWrapper.hpp"
 #include "DataStructures.hpp"
+#include "MediaDataQueue.hpp"
+#include "StreamParameters.hpp"
 
 extern "C"
 {
@@ -17,6 +21,7 @@ namespace AVMuxer
 class alignas(8*sizeof(void*)) MediaStreamContext
 {
     friend int ioRead(void *opaque, uint8_t *buf, int bufsize);
+    friend int64_t ioSeek(void *opaque, int64_t offset, int whence);
     
     public:
         MediaStreamContext(AVStream* newStream);
@@ -25,16 +30,22 @@ class alignas(8*sizeof(void*)) MediaStreamContext
         ~MediaStreamContext();
 
         void fillBuffer(const ByteArray& data) const;
+        void attachBuffer(const SharedByteArray& data) const;
+        void queuePacket(const EncodedPacket& packet);
+        void setCodecParameters(const CodecParameters& params);
+        void setProbeHints(const StreamProbeHints& hints);
+        //Demuxer gets end of data instead of being asked to wait for more, so it returns everything it still holds
+        void finishInput();
         AVPacket getNextFrame();
 
         bool hasQueuedData() const
         {
-            return !mediaDataBuffer.empty();
+            return !inputState->mediaDataBuffer.empty() || (inputState->preframedInput && !inputState->preframedInput->packets.empty());
         }
 
         size_t getBufferedDataSize() const
         {
-            return mediaDataBuffer.size();
+            return inputState->mediaDataBuffer.size() + (inputState->preframedInput ? inputState->preframedInput->queuedSize : 0);
         }
 
         AVStream* getStream() const
@@ -44,20 +55,70 @@ class alignas(8*sizeof(void*)) MediaStreamContext
 
         operator bool() const
         {
-            return formatCtxt != nullptr;
+            return formatCtxt != nullptr || inputState->preframedInput != nullptr;
+        }
+
+        void setMaxPooledBufferSize(size_t maxPooledSize)
+        {
+            inputState->mediaDataBuffer.setMaxPooledSize(maxPooledSize);
+        }
+
+        void setBufferSpilling(size_t thresholdSize, const std::string& directory)
+        {
+            inputState->mediaDataBuffer.setSpilling(thresholdSize, directory);
         }
 
         bool initializeFormat();
+
+        unsigned int getProbeAttemptsCount() const
+        {
+            return inputState->probeAttemptsCount;
+        }
     
     private:
-        mutable ByteVector mediaDataBuffer;
-        AVFormatContext*   formatCtxt;
-        AVStream*          stream;
-        AVIOContextWrapper ioCtxt;
-        mutable int        posInBuffer;
-        unsigned int       packetsCount;
-
-        void reset();
+        struct PreframedInput
+        {
+            std::deque<AVPacket> packets;
+            AVRational           timeBase;
+            int64_t              defaultDuration;
+            size_t               queuedSize;
+        };
+
+        struct ProbeSettings
+        {
+            decltype(av_find_input_format("")) inputFormat;
+            AVCodecID                          codecId;
+            int64_t                            probeSize;
+            int64_t                            analyzeDuration;
+            ByteVector                         extradata;
+        };
+
+        //Input buffer and state used less often than on every read are kept out of line,
+        //so context itself stays within cache line
+        struct InputState
+        {
+            MediaDataQueue                  mediaDataBuffer;
+            uint64_t                        ioStartPosition = 0;
+            unsigned int                    probeAttemptsCount = 0;
+            size_t                          nextProbeAttemptSize = 0;
+            std::unique_ptr<PreframedInput> preframedInput;
+            std::unique_ptr<ProbeSettings>  probeSettings;
+        };
+
+        AVFormatContext*            formatCtxt;
+        AVStream*                   stream;
+        AVIOContextWrapper          ioCtxt;
+        std::unique_ptr<InputState> inputState;
+        unsigned int                packetsCount;
+        bool                        isProbing;
+        bool                        isStarved;
+        bool                        isWaitingForData;
+        bool                        isInputFinished;
+
+        AVPacket takeQueuedPacket();
+        void     applyProbeSettings();
+        void     rewindInput(int64_t position);
+        void     reset();
 };
 
 static_assert(sizeof(MediaStreamContext) == 32 || sizeof(MediaStreamContext) == 64);
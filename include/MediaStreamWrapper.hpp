@@ -1,8 +1,10 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include "MediaStreamContext.hpp"
+#include "Metrics.hpp"
 
 namespace AVMuxer
 {
@@ -17,22 +19,104 @@ class MediaStreamWrapper
 
         void updateRelativeTimeAhead(int64_t diff)
         {
-            relativeTimeAhead += diff;
+            relativeTimeAhead.add(diff);
         }
 
         int64_t getRelativeTimeAhead() const
         {
-            return relativeTimeAhead;
+            return relativeTimeAhead.get();
+        }
+
+        //Counted by muxer for every stream (also mocked ones)
+        void countMuxedPacket()
+        {
+            packetsMuxed.add(1);
+        }
+
+        void countLimiting()
+        {
+            limitedCount.add(1);
+        }
+
+        //Starvation bookkeeping, done by muxer only when its starvation timeout is set
+        void markInputReceived(std::chrono::steady_clock::time_point time)
+        {
+            lastInputTime = time;
+        }
+
+        std::chrono::steady_clock::time_point getLastInputTime() const
+        {
+            return lastInputTime;
+        }
+
+        bool isStalled() const
+        {
+            return stalled;
+        }
+
+        //Finished stream is left out of interleaving the same way once it's drained, but it's not counted as stalled
+        void setStalled(bool isStalled)
+        {
+            if(isStalled && !stalled && !inputFinished)
+                stalledCount.add(1);
+            stalled = isStalled;
+        }
+
+        void markInputFinished()
+        {
+            inputFinished = true;
+        }
+
+        bool isInputFinished() const
+        {
+            return inputFinished;
+        }
+
+        //Safe to call from any thread
+        StreamMetrics getMetrics() const
+        {
+            return StreamMetrics { inputBytes.get(), bufferedBytes.get(), packetsMuxed.get(), limitedCount.get(),
+                                   stalledCount.get(), probeAttempts.get(), relativeTimeAhead.get() };
         }
         
         virtual void fillBuffer(const ByteArray& data) const
         {
-            return streamCtxt->fillBuffer(data);
+            streamCtxt->fillBuffer(data);
+            countInput(data.size);
+        }
+
+        virtual void attachBuffer(const SharedByteArray& data) const
+        {
+            streamCtxt->attachBuffer(data);
+            countInput(data.size);
+        }
+
+        virtual void queuePacket(const EncodedPacket& packet)
+        {
+            streamCtxt->queuePacket(packet);
+            countInput(packet.data.size);
+        }
+
+        virtual void setCodecParameters(const CodecParameters& params)
+        {
+            streamCtxt->setCodecParameters(params);
+        }
+
+        virtual void setProbeHints(const StreamProbeHints& hints)
+        {
+            streamCtxt->setProbeHints(hints);
+        }
+
+        virtual void finishInput()
+        {
+            streamCtxt->finishInput();
         }
 
         virtual AVPacket getNextFrame()
         {
-            return streamCtxt->getNextFrame();
+            auto packet = streamCtxt->getNextFrame();
+            bufferedBytes.set(streamCtxt->getBufferedDataSize());
+            return packet;
         }
 
         virtual bool hasQueuedData() const
@@ -45,6 +129,16 @@ class MediaStreamWrapper
             return streamCtxt->getBufferedDataSize();
         }
 
+        virtual void setMaxPooledBufferSize(size_t maxPooledSize)
+        {
+            streamCtxt->setMaxPooledBufferSize(maxPooledSize);
+        }
+
+        virtual void setBufferSpilling(size_t thresholdSize, const std::string& directory)
+        {
+            streamCtxt->setBufferSpilling(thresholdSize, directory);
+        }
+
         virtual AVRational getTimeBase() const
         {
             return streamCtxt->getStream()->time_base;
@@ -52,7 +146,13 @@ class MediaStreamWrapper
 
         virtual operator bool()
         {
-            return (*streamCtxt || streamCtxt->initializeFormat());
+            if(*streamCtxt)
+                return true;
+
+            auto isInitialized = streamCtxt->initializeFormat();
+            probeAttempts.set(streamCtxt->getProbeAttemptsCount());
+            bufferedBytes.set(streamCtxt->getBufferedDataSize());
+            return isInitialized;
         }
 
     protected:
@@ -61,7 +161,22 @@ class MediaStreamWrapper
         }
 
     private:
-        int64_t relativeTimeAhead = 0;
-        std::shared_ptr<MediaStreamContext> streamCtxt;
+        MetricCounter<int64_t>                relativeTimeAhead;
+        mutable MetricCounter<uint64_t>       inputBytes;
+        mutable MetricCounter<uint64_t>       bufferedBytes;
+        MetricCounter<uint64_t>               packetsMuxed;
+        MetricCounter<uint64_t>               limitedCount;
+        MetricCounter<uint64_t>               stalledCount;
+        MetricCounter<uint64_t>               probeAttempts;
+        std::shared_ptr<MediaStreamContext>   streamCtxt;
+        std::chrono::steady_clock::time_point lastInputTime;
+        bool                                  stalled = false;
+        bool                                  inputFinished = false;
+
+        void countInput(size_t size) const
+        {
+            inputBytes.add(size);
+            bufferedBytes.set(streamCtxt->getBufferedDataSize());
+        }
 };
 }
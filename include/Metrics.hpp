@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace AVMuxer
+{
+//Snapshots of muxer's counters; sizes are in bytes, times in AV_TIME_BASE units
+struct StreamMetrics
+{
+    uint64_t inputBytes = 0;
+    uint64_t bufferedBytes = 0;
+    uint64_t packetsMuxed = 0;
+    //How many times stream was held back for being too far ahead of others
+    uint64_t limitedCount = 0;
+    //How many times stream was left out of interleaving for not receiving data within starvation timeout
+    uint64_t stalledCount = 0;
+    uint64_t probeAttempts = 0;
+    int64_t  relativeTimeAhead = 0;
+};
+
+struct MuxerMetrics
+{
+    uint64_t                   packetsMuxed = 0;
+    uint64_t                   outputBytes = 0;
+    std::vector<StreamMetrics> streams;
+};
+
+//Counters are written only by muxing thread, so they're updated without atomic read-modify-write;
+//atomics only make them safe to read from other thread (ie. metrics poller)
+template <class T>
+class MetricCounter
+{
+    public:
+        void add(T value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        void set(T value)
+        {
+            counter.store(value, std::memory_order_relaxed);
+        }
+
+        T get() const
+        {
+            return counter.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<T> counter = 0;
+};
+}
@@ -7,7 +7,12 @@ namespace AVMuxer
 class AudioVideoMp4Muxer : public Muxer<2>
 {
     public:
-        AudioVideoMp4Muxer(AVRational framerate) : Muxer<2>("mp4", framerate)
+        AudioVideoMp4Muxer(AVRational framerate, OutputSinkSharedPtr outputSink = nullptr)
+            : Muxer<2>("mp4", framerate, outputSink)
+        {}
+
+        AudioVideoMp4Muxer(AVRational framerate, const std::array<StreamProbeHints, 2>& probeHints, OutputSinkSharedPtr outputSink = nullptr)
+            : Muxer<2>("mp4", framerate, probeHints, outputSink)
         {}
 
         template <class ContainerT>
@@ -26,7 +31,12 @@ class AudioVideoMp4Muxer : public Muxer<2>
 class VideoOnlyMp4Muxer : public Muxer<1>
 {
     public:
-        VideoOnlyMp4Muxer(AVRational framerate) : Muxer<1>("mp4", framerate)
+        VideoOnlyMp4Muxer(AVRational framerate, OutputSinkSharedPtr outputSink = nullptr)
+            : Muxer<1>("mp4", framerate, outputSink)
+        {}
+
+        VideoOnlyMp4Muxer(AVRational framerate, const std::array<StreamProbeHints, 1>& probeHints, OutputSinkSharedPtr outputSink = nullptr)
+            : Muxer<1>("mp4", framerate, probeHints, outputSink)
         {}
 
         template <class ContainerT>
@@ -2,9 +2,11 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <limits>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include "BaseMuxer.hpp"
 #include "MediaStreamWrapper.hpp"
@@ -17,11 +19,13 @@ class Muxer : public BaseMuxer
     static_assert(StreamsCount > 0);
 
     public:
-        Muxer(const char* formatName, AVRational framerate) : Muxer(formatName, std::array {framerate})
+        Muxer(const char* formatName, AVRational framerate, OutputSinkSharedPtr outputSink = nullptr)
+            : Muxer(formatName, std::array {framerate}, outputSink)
         {}
 
         template <long unsigned VideoStreamsCount>
-        Muxer(const char* formatName, const std::array<AVRational, VideoStreamsCount>& framerates) : BaseMuxer(formatName)
+        Muxer(const char* formatName, const std::array<AVRational, VideoStreamsCount>& framerates, OutputSinkSharedPtr outputSink = nullptr)
+            : BaseMuxer(formatName, outputSink)
         {
             static_assert(VideoStreamsCount <= StreamsCount);
 
@@ -38,23 +42,25 @@ class Muxer : public BaseMuxer
                 *(currentStream++) = containerCtxt->createStream();
         }
 
+        Muxer(const char* formatName, AVRational framerate, const std::array<StreamProbeHints, StreamsCount>& probeHints,
+              OutputSinkSharedPtr outputSink = nullptr)
+            : Muxer(formatName, std::array {framerate}, probeHints, outputSink)
+        {}
+
+        template <long unsigned VideoStreamsCount>
+        Muxer(const char* formatName, const std::array<AVRational, VideoStreamsCount>& framerates,
+              const std::array<StreamProbeHints, StreamsCount>& probeHints, OutputSinkSharedPtr outputSink = nullptr)
+            : Muxer(formatName, framerates, outputSink)
+        {
+            for(unsigned i = 0; i < StreamsCount; ++i)
+                streams[i]->setProbeHints(probeHints[i]);
+        }
+
         void updateStreamRelativeTimeAhead(MediaStreamWrapper& mediaCtxt, int64_t diff) override
         {
             mediaCtxt.updateRelativeTimeAhead(diff);
-            if(!shouldStreamBeLimited(mediaCtxt))
-                return;
-            
-            auto minTimeAhead = std::numeric_limits<int64_t>::max();
-            std::for_each(streams.begin(), streams.end(), [&minTimeAhead](const auto& current)
-            {
-                if(auto time = current->getRelativeTimeAhead(); time < minTimeAhead)
-                    minTimeAhead = time;
-            });
-
-            std::for_each(streams.begin(), streams.end(), [minTimeAhead](auto& current)
-            {
-                current->updateRelativeTimeAhead(-minTimeAhead);
-            });
+            if(shouldStreamBeLimited(mediaCtxt))
+                normalizeRelativeTimeAhead();
         }
 
         static auto getStreamsCount()
@@ -75,6 +81,85 @@ class Muxer : public BaseMuxer
             return hasMuxedData();
         }
 
+        //Muxes caller's buffer without copying it - it's kept alive by its owner until it's been demuxed
+        template <unsigned StreamNumber>
+        bool muxMediaData(const SharedByteArray& inputData)
+        {
+            static_assert(StreamNumber < StreamsCount);
+            BaseMuxer::muxMediaData(*streams[StreamNumber], inputData);
+            return hasMuxedData();
+        }
+
+        //Non-blocking variants of muxMediaData() - input is refused (and not buffered) if it would exceed buffer budgets,
+        //so producer can throttle until stream's data is demuxed
+        template <unsigned StreamNumber, class ContainerT>
+        TryMuxResult tryMuxMediaData(const ContainerT& inputData)
+        {
+            static_assert(StreamNumber < StreamsCount);
+            if(wouldExceedBudget(*streams[StreamNumber], inputData.size()))
+                return TryMuxResult::WOULD_EXCEED_BUDGET;
+
+            muxMediaData<StreamNumber>(inputData);
+            return TryMuxResult::ACCEPTED;
+        }
+
+        template <unsigned StreamNumber>
+        TryMuxResult tryMuxMediaData(const SharedByteArray& inputData)
+        {
+            static_assert(StreamNumber < StreamsCount);
+            if(wouldExceedBudget(*streams[StreamNumber], inputData.size))
+                return TryMuxResult::WOULD_EXCEED_BUDGET;
+
+            muxMediaData<StreamNumber>(inputData);
+            return TryMuxResult::ACCEPTED;
+        }
+
+        //Sets stream up for muxing already framed packets (see muxPacket()) - no probing or demuxing is done for it
+        template <unsigned StreamNumber>
+        void setCodecParameters(const CodecParameters& params)
+        {
+            static_assert(StreamNumber < StreamsCount);
+            auto loggerScope = makeLoggerScope();
+            streams[StreamNumber]->setCodecParameters(params);
+        }
+
+        //Muxes single access unit; timestamps are in time base declared with setCodecParameters(),
+        //when duration is not given, it's derived from framerate (video) or frame size (audio)
+        template <unsigned StreamNumber>
+        bool muxPacket(const uint8_t* data, size_t size, int64_t pts, int64_t dts, bool isKeyframe, int64_t duration = 0)
+        {
+            static_assert(StreamNumber < StreamsCount);
+            BaseMuxer::muxPacket(*streams[StreamNumber], EncodedPacket { {data, size}, pts, dts, duration, isKeyframe });
+            return hasMuxedData();
+        }
+
+        //Tells that stream's input is over (ie. end of file) - demuxer then returns what it still holds (like the last frame,
+        //which otherwise waits for next one to begin), and once the stream is drained, it no longer holds other streams back;
+        //no more data can be muxed for the stream afterwards
+        template <unsigned StreamNumber>
+        bool finishInput()
+        {
+            static_assert(StreamNumber < StreamsCount);
+            BaseMuxer::finishInput(*streams[StreamNumber]);
+            return hasMuxedData();
+        }
+
+        //Limits memory each stream keeps for reuse once its input buffers are drained; it doesn't bound how much input
+        //is buffered - use setBufferLimits() for that
+        void setMaxPooledInputBufferSize(size_t maxPooledSize)
+        {
+            for(auto& stream : streams)
+                stream->setMaxPooledBufferSize(maxPooledSize);
+        }
+
+        //Input buffered by a stream beyond given size goes to temporary file in given directory (TMPDIR or /tmp
+        //by default) and is paged back in as it's demuxed, so long skew between streams doesn't grow resident memory
+        void setInputBufferSpilling(size_t thresholdSize, const std::string& directory = {})
+        {
+            for(auto& stream : streams)
+                stream->setBufferSpilling(thresholdSize, directory);
+        }
+
         bool flush()
         {
             flushAllStreams(std::make_index_sequence<StreamsCount>());
@@ -84,6 +169,30 @@ class Muxer : public BaseMuxer
         static constexpr unsigned STREAMS_COUNT = StreamsCount;
 
         private:
+            //Stalled streams are left out
+            int64_t getMinRelativeTimeAhead() const
+            {
+                auto minTimeAhead = std::numeric_limits<int64_t>::max();
+                std::for_each(streams.begin(), streams.end(), [&minTimeAhead](const auto& current)
+                {
+                    if(auto time = current->getRelativeTimeAhead(); time < minTimeAhead && !current->isStalled())
+                        minTimeAhead = time;
+                });
+                return minTimeAhead;
+            }
+
+            void normalizeRelativeTimeAhead()
+            {
+                auto minTimeAhead = getMinRelativeTimeAhead();
+                if(minTimeAhead == std::numeric_limits<int64_t>::max())
+                    return;
+
+                std::for_each(streams.begin(), streams.end(), [minTimeAhead](auto& current)
+                {
+                    current->updateRelativeTimeAhead(-minTimeAhead);
+                });
+            }
+
             template <std::size_t... StreamsIndices>
             int flushAllStreams(std::index_sequence<StreamsIndices...>)
             {
@@ -94,5 +203,55 @@ class Muxer : public BaseMuxer
     
     protected:
         std::array<WrappedMediaStreamSharedPtr, StreamsCount> streams;
+
+        bool excludeStalledStreams() override
+        {
+            auto now = getCurrentTime();
+            bool isAnyStreamExcluded = false;
+            for(auto& stream : streams)
+            {
+                if(isStreamStarved(*stream, now))
+                {
+                    stream->setStalled(true);
+                    isAnyStreamExcluded = true;
+                }
+            }
+
+            if(isAnyStreamExcluded)
+                normalizeRelativeTimeAhead();
+            return isAnyStreamExcluded;
+        }
+
+        void rejoinStream(MediaStreamWrapper& mediaCtxt) override
+        {
+            //Stream which fell behind while stalled resumes along with the slowest active one, instead of holding others back
+            auto minTimeAhead = getMinRelativeTimeAhead();
+            if(minTimeAhead != std::numeric_limits<int64_t>::max() && mediaCtxt.getRelativeTimeAhead() < minTimeAhead)
+                mediaCtxt.updateRelativeTimeAhead(minTimeAhead - mediaCtxt.getRelativeTimeAhead());
+            mediaCtxt.setStalled(false);
+        }
+
+        void leaveInterleaving(MediaStreamWrapper& mediaCtxt) override
+        {
+            mediaCtxt.setStalled(true);
+            normalizeRelativeTimeAhead();
+        }
+
+        std::vector<StreamMetrics> getStreamsMetrics() const override
+        {
+            std::vector<StreamMetrics> metrics;
+            metrics.reserve(StreamsCount);
+            for(const auto& stream : streams)
+                metrics.push_back(stream->getMetrics());
+            return metrics;
+        }
+
+        size_t getStreamsBufferedSize() const override
+        {
+            size_t bufferedSize = 0;
+            for(const auto& stream : streams)
+                bufferedSize += stream->getBufferedDataSize();
+            return bufferedSize;
+        }
 };
 }
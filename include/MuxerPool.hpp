@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace AVMuxer
+{
+class MuxerPool;
+
+//Unit of work driven by MuxerPool - call schedule() whenever session has something to do, and process()
+//will be called on one of pool's workers. Session is never processed by two workers at the same time
+class PoolSession : public std::enable_shared_from_this<PoolSession>
+{
+    public:
+        virtual ~PoolSession() = default;
+
+        //Safe to call from any thread; scheduling already scheduled (or failed) session is no-op.
+        //Throws MuxerException if session hasn't been added to any pool
+        void schedule();
+
+        //Exception thrown by process() - once it's set, session is not processed anymore
+        std::exception_ptr getError() const;
+
+    protected:
+        virtual void process() = 0;
+
+    private:
+        enum State { IDLE, SCHEDULED, RUNNING, RESCHEDULED, FAILED };
+
+        friend class MuxerPool;
+
+        std::atomic<State> state = IDLE;
+        MuxerPool*         pool = nullptr;
+        unsigned           homeWorker = 0;
+        std::exception_ptr error;
+};
+
+using PoolSessionSharedPtr = std::shared_ptr<PoolSession>;
+
+//Runs many sessions on fixed set of worker threads. Every session has its home worker, which processes it
+//whenever it's not busy, so session's state stays cache-warm; idle workers steal from busy ones.
+//Pool has to outlive all of its sessions' schedule() calls
+class MuxerPool
+{
+    public:
+        explicit MuxerPool(unsigned workersCount = std::thread::hardware_concurrency());
+        ~MuxerPool();
+
+        MuxerPool(const MuxerPool&) = delete;
+        MuxerPool& operator=(const MuxerPool&) = delete;
+
+        template <class SessionT, class... Args>
+        std::shared_ptr<SessionT> createSession(Args&&... args)
+        {
+            auto session = std::make_shared<SessionT>(std::forward<Args>(args)...);
+            addSession(session);
+            return session;
+        }
+
+        //Binds session to this pool, assigning its home worker
+        void addSession(const PoolSessionSharedPtr& session);
+
+        unsigned getWorkersCount() const
+        {
+            return workers.size();
+        }
+
+        //Workers sleeping because they've found nothing to do or steal
+        unsigned getIdleWorkersCount() const
+        {
+            return sleepingCount.load(std::memory_order_relaxed);
+        }
+
+    private:
+        //Worker's own queue along with its sleeping state - each worker sleeps on its own condition, so session
+        //scheduled while its home worker is idle wakes exactly that worker
+        struct alignas(CACHE_LINE_SIZE) WorkQueue
+        {
+            std::mutex                       mutex;
+            std::deque<PoolSessionSharedPtr> sessions;
+            std::condition_variable          wakeUpCondition;
+            bool                             isSleeping = false;
+            //Set when worker is woken up to steal from others, as its own queue may be empty
+            bool                             isWakeUpRequested = false;
+            std::atomic<bool>                isRunningSession = false;
+        };
+
+        friend class PoolSession;
+
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::vector<std::thread>                workers;
+        std::atomic<unsigned>                   sleepingCount = 0;
+        std::atomic<unsigned>                   nextHomeWorker = 0;
+        std::atomic<bool>                       isStopping = false;
+
+        void enqueue(PoolSessionSharedPtr session);
+        void wakeUpThief(unsigned homeWorker);
+        PoolSessionSharedPtr takeWork(unsigned workerIndex);
+        void runSession(const PoolSessionSharedPtr& session);
+        void runWorker(unsigned workerIndex);
+};
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "ChunkedByteQueue.hpp"
+#include "DataStructures.hpp"
+
+namespace AVMuxer
+{
+struct SegmentInfo
+{
+    bool     isInitSegment = false;
+    unsigned sequenceNumber = 0;
+    //Chunk's index within its segment (sequenceNumber), zero for whole segments
+    unsigned chunkNumber = 0;
+    //In AV_TIME_BASE units; both are zero for init segment
+    int64_t  startTime = 0;
+    int64_t  duration = 0;
+};
+
+//Destination of muxed data - written to directly from AVIO write callback, chunk by chunk
+class IOutputSink
+{
+    public:
+        virtual ~IOutputSink() = default;
+
+        //Returns number of consumed bytes or negative AVERROR code (which makes muxing fail)
+        virtual int write(const uint8_t* data, int size) = 0;
+
+        //Sinks keeping muxed data for later retrieval override these
+        virtual bool hasPendingData() const
+        {
+            return false;
+        }
+
+        virtual size_t getPendingDataSize() const
+        {
+            return 0;
+        }
+
+        virtual ByteVector takeData()
+        {
+            return {};
+        }
+
+        virtual size_t read(uint8_t*, size_t)
+        {
+            return 0;
+        }
+
+        //Called when segmenting is enabled, right after last byte of segment was written
+        virtual void closeSegment(const SegmentInfo&)
+        {
+        }
+
+        //Called in low-latency mode, right after last byte of chunk was written (and before closeSegment()
+        //if chunk is segment's last one)
+        virtual void closeChunk(const SegmentInfo&)
+        {
+        }
+};
+
+using OutputSinkSharedPtr = std::shared_ptr<IOutputSink>;
+
+//Default sink - keeps muxed data in recycled chunks until it's retrieved
+//with getMuxedData() or drained into caller's buffers with readMuxedData()
+class ChunkedBufferSink : public IOutputSink
+{
+    public:
+        int write(const uint8_t* data, int size) override;
+
+        bool hasPendingData() const override
+        {
+            return !muxedData.empty();
+        }
+
+        size_t getPendingDataSize() const override
+        {
+            return muxedData.size();
+        }
+
+        ByteVector takeData() override;
+        size_t     read(uint8_t* dst, size_t capacity) override;
+
+    private:
+        ChunkedByteQueue muxedData;
+};
+
+//Accumulates muxed data in single vector until it's retrieved; data drained by read() is dropped
+//from the vector only once it's at least half of it, so partial reads don't move the rest each time
+class ByteVectorSink : public IOutputSink
+{
+    public:
+        int write(const uint8_t* data, int size) override;
+
+        bool hasPendingData() const override
+        {
+            return readOffset < muxedData.size();
+        }
+
+        size_t getPendingDataSize() const override
+        {
+            return muxedData.size() - readOffset;
+        }
+
+        ByteVector takeData() override;
+        size_t     read(uint8_t* dst, size_t capacity) override;
+
+    private:
+        ByteVector muxedData;
+        size_t     readOffset = 0;
+
+        void compact();
+};
+
+//Passes every chunk of muxed data to user's function (ie. one putting it into user's ring buffer);
+//returning false from it is treated as I/O error
+class CallbackSink : public IOutputSink
+{
+    public:
+        using Callback = std::function<bool(const ByteArray&)>;
+
+        CallbackSink(Callback&& outputCallback);
+
+        int write(const uint8_t* data, int size) override;
+
+    private:
+        Callback callback;
+};
+
+//Writes muxed data to blocking file descriptor (file, pipe, socket...); descriptor is not closed by the sink
+class FileDescriptorSink : public IOutputSink
+{
+    public:
+        FileDescriptorSink(int outputFd);
+
+        int write(const uint8_t* data, int size) override;
+
+    private:
+        int fd;
+};
+
+//Collects muxed data into separate objects, one per segment (see ContainerOptions::segmentDuration),
+//and passes each of them to user's function once it's complete. In low-latency mode, chunks can also be
+//passed to another function as soon as they're complete - without copying, as they're parts of segment's data
+class SegmentSink : public IOutputSink
+{
+    public:
+        struct Segment
+        {
+            SegmentInfo info;
+            ByteVector  data;
+        };
+
+        using Callback = std::function<void(Segment&&)>;
+        using ChunkCallback = std::function<void(const SegmentInfo&, const ByteArray&)>;
+
+        SegmentSink(Callback&& segmentCallback, ChunkCallback&& chunkCallback = nullptr);
+
+        int  write(const uint8_t* data, int size) override;
+        void closeSegment(const SegmentInfo& info) override;
+        void closeChunk(const SegmentInfo& info) override;
+
+    private:
+        Callback      callback;
+        ChunkCallback chunkCallback;
+        ByteVector    segmentData;
+        size_t        chunkStartOffset = 0;
+};
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include "ConcurrentMuxer.hpp"
+#include "MuxerPool.hpp"
+
+namespace AVMuxer
+{
+//Muxer driven by MuxerPool instead of its own thread - create it with MuxerPool::createSession().
+//Pushing input schedules the session, and pool's worker muxes it; muxed data is delivered from that worker
+//through output sink passed to the constructor, so a sink that pushes data out has to be given - there's no default one.
+//If muxing fails, session isn't processed anymore, pushing input starts returning false and getError() tells why
+template <unsigned StreamsCount>
+class PooledMuxer : public PoolSession, protected ConcurrentMuxer<StreamsCount>
+{
+    using Base = ConcurrentMuxer<StreamsCount>;
+
+    public:
+        PooledMuxer(const char* formatName, AVRational framerate, OutputSinkSharedPtr outputSink)
+            : Base(formatName, framerate, requireSink(outputSink))
+        {}
+
+        template <long unsigned VideoStreamsCount>
+        PooledMuxer(const char* formatName, const std::array<AVRational, VideoStreamsCount>& framerates, OutputSinkSharedPtr outputSink)
+            : Base(formatName, framerates, requireSink(outputSink))
+        {}
+
+        PooledMuxer(const char* formatName, AVRational framerate, const std::array<StreamProbeHints, StreamsCount>& probeHints,
+                    OutputSinkSharedPtr outputSink)
+            : Base(formatName, framerate, probeHints, requireSink(outputSink))
+        {}
+
+        template <long unsigned VideoStreamsCount>
+        PooledMuxer(const char* formatName, const std::array<AVRational, VideoStreamsCount>& framerates,
+                    const std::array<StreamProbeHints, StreamsCount>& probeHints, OutputSinkSharedPtr outputSink)
+            : Base(formatName, framerates, probeHints, requireSink(outputSink))
+        {}
+
+        using Base::getMetrics;
+        using Base::getStreamsCount;
+        using Base::STREAMS_COUNT;
+
+        //Configuration - these have to be called before any input is pushed; buffer limits' watermark callbacks
+        //are then run on pool's workers
+        using Base::setContainerOptions;
+        using Base::addOutput;
+        using Base::setBufferLimits;
+        using Base::setStarvationTimeout;
+        using Base::setCodecParameters;
+        using Base::setMaxPooledInputBufferSize;
+        using Base::setInputBufferSpilling;
+
+        template <unsigned StreamNumber, class ContainerT>
+        bool pushMediaData(const ContainerT& inputData)
+        {
+            if(getError() || !Base::template pushMediaData<StreamNumber>(inputData))
+                return false;
+
+            schedule();
+            return true;
+        }
+
+        //Already framed packet for stream set up with setCodecParameters() (see Muxer::muxPacket()); data is copied
+        template <unsigned StreamNumber>
+        bool pushPacket(const uint8_t* data, size_t size, int64_t pts, int64_t dts, bool isKeyframe, int64_t duration = 0)
+        {
+            if(getError() || !Base::template pushPacket<StreamNumber>(data, size, pts, dts, isKeyframe, duration))
+                return false;
+
+            schedule();
+            return true;
+        }
+
+        //Stream's input is finished by pool's worker, after data pushed before is processed (see Muxer::finishInput())
+        template <unsigned StreamNumber>
+        bool finishInput()
+        {
+            if(getError() || !Base::template pushEndOfInput<StreamNumber>())
+                return false;
+
+            schedule();
+            return true;
+        }
+
+        void requestFlush()
+        {
+            isFlushRequested.store(true, std::memory_order_release);
+            schedule();
+        }
+
+        //Same as requestFlush(), but current media segment is then ended (see BaseMuxer::cutSegment())
+        void requestSegmentCut()
+        {
+            isSegmentCutRequested.store(true, std::memory_order_release);
+            schedule();
+        }
+
+        //Same as requestFlush(), but muxing is then ended and container's trailer is written (see BaseMuxer::finish());
+        //request it once all streams' input is finished - input pushed afterwards makes session fail
+        void requestFinish()
+        {
+            isFinishRequested.store(true, std::memory_order_release);
+            schedule();
+        }
+
+        //Logger is swapped by pool's worker, next time the session is processed
+        void setLogger(std::shared_ptr<ILogger> muxerLogger)
+        {
+            std::lock_guard lock(loggerMutex);
+            pendingLogger = std::move(muxerLogger);
+            isLoggerChanged.store(true, std::memory_order_relaxed);
+        }
+
+    protected:
+        void process() override
+        {
+            //Flag is set and cleared only under the mutex, so pending logger is always the latest one once it's seen
+            if(isLoggerChanged.load(std::memory_order_relaxed))
+            {
+                std::lock_guard lock(loggerMutex);
+                Base::setLogger(std::move(pendingLogger));
+                isLoggerChanged.store(false, std::memory_order_relaxed);
+            }
+
+            //Requests are taken before queued input, so input pushed before them is always processed first
+            bool shouldFinish = isFinishRequested.exchange(false, std::memory_order_acquire);
+            bool shouldCutSegment = isSegmentCutRequested.exchange(false, std::memory_order_acquire);
+            bool shouldFlush = isFlushRequested.exchange(false, std::memory_order_acquire) || shouldCutSegment || shouldFinish;
+
+            Base::processQueuedData();
+            if(shouldFlush)
+                Base::flush();
+            //Finishing closes current segment as well
+            if(shouldFinish)
+                Base::finish();
+            else if(shouldCutSegment)
+                Base::cutSegment();
+        }
+
+    private:
+        std::atomic<bool>        isFlushRequested = false;
+        std::atomic<bool>        isSegmentCutRequested = false;
+        std::atomic<bool>        isFinishRequested = false;
+        std::mutex               loggerMutex;
+        std::shared_ptr<ILogger> pendingLogger;
+        std::atomic<bool>        isLoggerChanged = false;
+
+        static OutputSinkSharedPtr requireSink(OutputSinkSharedPtr outputSink)
+        {
+            if(!outputSink)
+                throw std::invalid_argument("PooledMuxer needs output sink - muxed data can't be retrieved from pool's workers");
+            return outputSink;
+        }
+};
+}
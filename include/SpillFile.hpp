@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "utils.hpp"
+
+namespace AVMuxer
+{
+//Unlinked temporary file that buffered input overflows to. Data is written at the end of file and read back
+//through read-only mappings of fixed-size windows, so it's paged in only when it's read, and leaves
+//resident memory once its window is unmapped. Released windows' disk space is given back as well
+class SpillFile : public std::enable_shared_from_this<SpillFile>
+{
+    public:
+        static constexpr size_t WINDOW_SIZE = 256 * PAGE_SIZE;
+
+        struct Window
+        {
+            const uint8_t*              data;
+            uint64_t                    offset;
+            //Window is unmapped when it's released
+            std::shared_ptr<const void> owner;
+        };
+
+        //Returns null if file can't be created in given directory (or in TMPDIR or /tmp, if it's empty)
+        static std::shared_ptr<SpillFile> open(const std::string& directory);
+
+        SpillFile(const SpillFile&) = delete;
+        SpillFile(SpillFile&&) = delete;
+        ~SpillFile();
+
+        //Reserves next window at the end of file; data is null if it couldn't be mapped
+        Window mapWindow();
+        bool   write(uint64_t offset, const uint8_t* data, size_t size);
+
+    private:
+        int      fd;
+        uint64_t nextWindowOffset;
+        unsigned mappedWindowsCount;
+
+        explicit SpillFile(int fileDescriptor);
+
+        void releaseWindow(void* mapping, uint64_t offset);
+};
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "utils.hpp"
+
+namespace AVMuxer
+{
+//Bounded lock-free queue for exactly one producer thread and one consumer thread.
+//Capacity is rounded up to power of two; each side caches the other side's index,
+//so shared cache lines are touched only when queue looks full (producer) or empty (consumer)
+template <class T>
+class SpscQueue
+{
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 256;
+
+        SpscQueue(size_t minCapacity = DEFAULT_CAPACITY)
+            : writeIndex(0), cachedReadIndex(0), readIndex(0), cachedWriteIndex(0),
+              capacity(roundUpToPowerOfTwo(minCapacity)), slots(new T[capacity])
+        {}
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue(SpscQueue&&) = delete;
+
+        //Producer side
+        bool tryPush(T&& item)
+        {
+            auto index = writeIndex.load(std::memory_order_relaxed);
+            if(index - cachedReadIndex == capacity)
+            {
+                cachedReadIndex = readIndex.load(std::memory_order_acquire);
+                if(index - cachedReadIndex == capacity)
+                    return false;
+            }
+
+            slots[index & (capacity - 1)] = std::move(item);
+            writeIndex.store(index + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool isFull()
+        {
+            auto index = writeIndex.load(std::memory_order_relaxed);
+            if(index - cachedReadIndex < capacity)
+                return false;
+
+            cachedReadIndex = readIndex.load(std::memory_order_acquire);
+            return index - cachedReadIndex == capacity;
+        }
+
+        //Consumer side
+        bool tryPop(T& item)
+        {
+            auto index = readIndex.load(std::memory_order_relaxed);
+            if(index == cachedWriteIndex)
+            {
+                cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+                if(index == cachedWriteIndex)
+                    return false;
+            }
+
+            auto& slot = slots[index & (capacity - 1)];
+            item = std::move(slot);
+            slot = T();
+            readIndex.store(index + 1, std::memory_order_release);
+            return true;
+        }
+
+        //Either side
+        bool empty() const
+        {
+            return readIndex.load(std::memory_order_acquire) == writeIndex.load(std::memory_order_acquire);
+        }
+
+        size_t getCapacity() const
+        {
+            return capacity;
+        }
+
+    private:
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> writeIndex;
+        size_t                                       cachedReadIndex;
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> readIndex;
+        size_t                                       cachedWriteIndex;
+        alignas(CACHE_LINE_SIZE) const size_t        capacity;
+        std::unique_ptr<T[]>                         slots;
+
+        static size_t roundUpToPowerOfTwo(size_t value)
+        {
+            size_t result = 1;
+            while(result < value)
+                result <<= 1;
+            return result;
+        }
+};
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+#include "DataStructures.hpp"
+
+extern "C"
+{
+    #include <libavformat/avformat.h>
+}
+
+namespace AVMuxer
+{
+//Declares codec of stream fed with already framed packets, so no probing or demuxing is needed
+struct CodecParameters
+{
+    AVMediaType type;
+    AVCodecID   codecId;
+    AVRational  timeBase;       //Time base of timestamps of muxed packets
+    ByteVector  extradata;      //ie. avcC/hvcC for H.264/HEVC, AudioSpecificConfig for AAC
+    int         width      = 0;
+    int         height     = 0;
+    int         sampleRate = 0;
+    int         channels   = 0;
+    int         frameSize  = 0; //Samples per audio frame, used when packet duration isn't given
+};
+
+//Hints speeding up identification of stream's input format; empty/zero values leave libavformat's defaults
+struct StreamProbeHints
+{
+    const char* formatName      = nullptr;          //Input format (ie. "h264", "aac") - skips format detection
+    AVCodecID   codecId         = AV_CODEC_ID_NONE;
+    int64_t     probeSize       = 0;                //Max bytes read to identify stream, also bounds probing retries
+    int64_t     analyzeDuration = 0;                //Max duration (in AV_TIME_BASE units) analyzed to identify stream
+    ByteVector  extradata;                          //Used if input doesn't carry codec extradata itself
+};
+
+//Single access unit with its timing
+struct EncodedPacket
+{
+    ByteArray data;
+    int64_t   pts;
+    int64_t   dts;
+    int64_t   duration;
+    bool      isKeyframe;
+};
+}
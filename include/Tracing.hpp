@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+//Scoped spans of hot path stages, recorded only when library is built with TRACING_MODE defined
+//(AVMUXER_TRACING CMake option) - otherwise AVMUXER_TRACE_SCOPE() compiles to nothing
+#ifdef TRACING_MODE
+    #define AVMUXER_TRACE_CONCAT_IMPL(a, b) a##b
+    #define AVMUXER_TRACE_CONCAT(a, b) AVMUXER_TRACE_CONCAT_IMPL(a, b)
+    #define AVMUXER_TRACE_SCOPE(name) ::AVMuxer::Tracing::ScopedSpan AVMUXER_TRACE_CONCAT(traceSpan, __LINE__)(name)
+#else
+    #define AVMUXER_TRACE_SCOPE(name) ((void)0)
+#endif
+
+namespace AVMuxer::Tracing
+{
+//Spans are kept in per-thread ring buffers of this many entries - older ones are overwritten
+constexpr uint32_t RING_BUFFER_SIZE = 16384;
+
+//Name has to be string literal (or otherwise outlive the span)
+void recordSpan(const char* name, uint64_t startTimeNs, uint64_t durationNs);
+
+//Dumps recorded spans of all threads as Chrome trace JSON (loadable in Perfetto or chrome://tracing);
+//spans being recorded while dumping may be skipped
+void writeChromeTrace(std::ostream& output);
+
+//Drops all spans recorded so far
+void clear();
+
+inline uint64_t now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+class ScopedSpan
+{
+    public:
+        explicit ScopedSpan(const char* spanName) : name(spanName), startTime(now())
+        {}
+
+        ~ScopedSpan()
+        {
+            recordSpan(name, startTime, now() - startTime);
+        }
+
+        ScopedSpan(const ScopedSpan&) = delete;
+        ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+    private:
+        const char* name;
+        uint64_t    startTime;
+};
+}
@@ -3,31 +3,76 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <type_traits>
 
+#include "DataStructures.hpp"
 #include "Logger.hpp"
 
 class AVIOContext;
+struct AVBufferRef;
 
 namespace AVMuxer
 {
-template<int Size>
-struct alignas(Size) AlignedBuffer
+constexpr auto PAGE_SIZE = 4096;
+constexpr auto CACHE_LINE_SIZE = 8 * sizeof(void*);
+
+using IoProcedurePtr = int (void*, uint8_t*, int);
+
+std::string getAvErrorString(int errNr);
+
+//Logged as FFmpeg's error message, which is looked up only if message is actually logged
+struct AvErrorCode
 {
-    uint8_t buf[Size];
-    constexpr auto size() { return Size; }
-    operator uint8_t*() { return buf; }
+    int errNr;
 };
 
-constexpr auto PAGE_SIZE = 4096;
+inline void appendLogMessagePart(std::string& msg, const std::string& part) { msg += part; }
+inline void appendLogMessagePart(std::string& msg, const char* part) { msg += part; }
+inline void appendLogMessagePart(std::string& msg, AvErrorCode part) { msg += getAvErrorString(part.errNr); }
 
-using PageAlignedBuffer = AlignedBuffer<PAGE_SIZE>;
-using IoProcedurePtr = int (void*, uint8_t*, int);
+template <class Number, class = std::enable_if_t<std::is_arithmetic_v<Number>>>
+void appendLogMessagePart(std::string& msg, Number part)
+{
+    msg += std::to_string(part);
+}
+
+//Messages below given level are dropped before being formatted (DEBUG ones are logged only in DEBUG_MODE build anyway)
+void setLogLevel(LogLevel level);
+
+bool isLogLevelEnabled(LogLevel level);
 
 void log(const std::string& msg, LogLevel level);
 
-void setLogger(std::unique_ptr<ILogger>&& newLogger);
+//Message is concatenated from its parts (strings, numbers, AvErrorCode) only if it's going to be logged
+template <class... MsgParts>
+void log(LogLevel level, const MsgParts&... msgParts)
+{
+    if(!isLogLevelEnabled(level))
+        return;
 
-std::string getAvErrorString(int errNr);
+    std::string msg;
+    (appendLogMessagePart(msg, msgParts), ...);
+    log(msg, level);
+}
+
+//Can be called while other threads are logging; logger may be called from any thread muxing is done on
+void setLogger(std::shared_ptr<ILogger> newLogger);
+
+//While it exists, messages logged by current thread go to given logger instead of global one (null keeps current one)
+class LoggerScope
+{
+    public:
+        explicit LoggerScope(ILogger* logger);
+        ~LoggerScope();
+        LoggerScope(const LoggerScope&) = delete;
+        LoggerScope& operator=(const LoggerScope&) = delete;
+
+    private:
+        ILogger* previousLogger;
+};
+
+//Takes new reference to given buffer, so it can be passed to muxer without copying
+SharedByteArray makeSharedByteArray(const AVBufferRef* buffer);
 
 AVIOContext* makeIoContext(void* applicationData, IoProcedurePtr readProc, IoProcedurePtr writeProc);
 
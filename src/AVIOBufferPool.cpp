@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#include "AVIOBufferPool.hpp"
+#include "MuxerException.hpp"
+#include "utils.hpp"
+
+extern "C"
+{
+    #include <libavutil/mem.h>
+}
+
+namespace AVMuxer
+{
+namespace
+{
+    //Buffers released beyond that are freed
+    constexpr size_t MAX_POOLED_SIZE = 16 * 1024 * 1024;
+
+    std::atomic<size_t> defaultIoBufferSizes[] = { PAGE_SIZE, PAGE_SIZE };
+
+    size_t roundUpToPages(size_t size)
+    {
+        return std::max<size_t>(1, (size + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+    }
+}
+
+void setDefaultIoBufferSize(IoBufferRole role, size_t size)
+{
+    //FFmpeg takes buffer size as int
+    if(size == 0 || size > INT32_MAX / 2)
+        throw std::invalid_argument("Invalid I/O buffer size");
+
+    defaultIoBufferSizes[static_cast<int>(role)].store(roundUpToPages(size), std::memory_order_relaxed);
+}
+
+size_t getDefaultIoBufferSize(IoBufferRole role)
+{
+    return defaultIoBufferSizes[static_cast<int>(role)].load(std::memory_order_relaxed);
+}
+
+AVIOBufferPool& AVIOBufferPool::getInstance()
+{
+    //Never destroyed, so buffers can still be returned by muxers destroyed at exit
+    static auto pool = new AVIOBufferPool;
+    return *pool;
+}
+
+uint8_t* AVIOBufferPool::acquire(size_t size)
+{
+    {
+        std::lock_guard lock(mutex);
+        if(auto buffers = freeBuffers.find(size); buffers != freeBuffers.end() && !buffers->second.empty())
+        {
+            auto buffer = buffers->second.back();
+            buffers->second.pop_back();
+            pooledSize -= size;
+            return buffer;
+        }
+    }
+
+    auto buffer = static_cast<uint8_t*>(av_malloc(size));
+    if(buffer == nullptr)
+        throw MuxerException("Couldn't allocate I/O buffer");
+    return buffer;
+}
+
+void AVIOBufferPool::release(uint8_t* buffer, size_t size)
+{
+    {
+        std::lock_guard lock(mutex);
+        if(pooledSize + size <= MAX_POOLED_SIZE)
+        {
+            freeBuffers[size].push_back(buffer);
+            pooledSize += size;
+            return;
+        }
+    }
+
+    av_free(buffer);
+}
+
+size_t AVIOBufferPool::getPooledSize() const
+{
+    std::lock_guard lock(mutex);
+    return pooledSize;
+}
+}
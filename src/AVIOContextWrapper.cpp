@@ -1,47 +1,68 @@
-#include <memory>
+#include <stdexcept>
 
 #include "AVIOContextWrapper.hpp"
 #include "MuxerException.hpp"
 #include "utils.hpp"
 
+extern "C"
+{
+    #include <libavutil/mem.h>
+}
+
 namespace AVMuxer
 {
-AVIOContextWrapper::AVIOContextWrapper(void* applicationData, IoProcedurePtr readProc, IoProcedurePtr writeProc)
+AVIOContextWrapper::AVIOContextWrapper(void* applicationData, const IoProcedures& ioProcedures)
+    : context(nullptr), appData(applicationData), procedures(&ioProcedures), requestedBufferSize(0)
 {
-    log("Creating AVIOContextWrapper instance", LogLevel::DEBUG);
-    initialize(applicationData, readProc, writeProc);
+    log(LogLevel::DEBUG, "Creating AVIOContextWrapper instance");
 }
 
 AVIOContextWrapper::~AVIOContextWrapper()
 {
-    log("Deleting AVIOContextWrapper instance", LogLevel::DEBUG);
+    log(LogLevel::DEBUG, "Deleting AVIOContextWrapper instance");
     deinitialize();
 }
 
 void AVIOContextWrapper::reset()
 {
-    auto appData = context->opaque;
-    auto readProc = context->read_packet;
-    auto writeProc = context->write_packet;
     deinitialize();
-    initialize(appData, readProc, writeProc);
 }
 
-void AVIOContextWrapper::initialize(void* applicationData, IoProcedurePtr readProc, IoProcedurePtr writeProc)
+void AVIOContextWrapper::setBufferSize(size_t size)
 {
-    if(auto buffer = std::make_unique<PageAlignedBuffer>();
-       (context = avio_alloc_context(*buffer, buffer->size(), (writeProc == nullptr ? 0 : 1), applicationData, readProc, writeProc, nullptr)) == nullptr)
+    //FFmpeg takes buffer size as int
+    if(size > INT32_MAX / 2)
+        throw std::invalid_argument("Invalid I/O buffer size");
+
+    requestedBufferSize = (size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+}
+
+void AVIOContextWrapper::initialize()
+{
+    bool isWriting = procedures->writeProc != nullptr;
+    auto bufferSize = requestedBufferSize > 0 ? requestedBufferSize
+                                              : getDefaultIoBufferSize(isWriting ? IoBufferRole::OUTPUT : IoBufferRole::INPUT);
+    auto buffer = AVIOBufferPool::getInstance().acquire(bufferSize);
+    context = avio_alloc_context(buffer, bufferSize, (isWriting ? 1 : 0), appData, procedures->readProc, procedures->writeProc, procedures->seekProc);
+    if(context == nullptr)
     {
+        AVIOBufferPool::getInstance().release(buffer, bufferSize);
         throw MuxerException("Could not initialize I/O context - avio_alloc_context() failed");
     }
-    else
-        buffer.release();
 }
 
 void AVIOContextWrapper::deinitialize()
 {
-    if(context->buffer != nullptr)
-        delete reinterpret_cast<PageAlignedBuffer*>(context->buffer);
+    if(context == nullptr)
+        return;
+
+    //FFmpeg may have replaced buffer with its own one (ie. when rewinding after probing or resizing it) - it's allocated
+    //with av_malloc() as well, so it's pooled too if its size is whole pages (and freed otherwise)
+    if(context->buffer != nullptr && context->buffer_size > 0 && context->buffer_size % PAGE_SIZE == 0)
+        AVIOBufferPool::getInstance().release(context->buffer, context->buffer_size);
+    else
+        av_freep(&context->buffer);
+
     avio_context_free(&context);
 }
 }
@@ -0,0 +1,122 @@
+#include <cstdint>
+#include <string>
+
+#include "AsyncLogger.hpp"
+
+namespace AVMuxer
+{
+namespace
+{
+size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while(result < value)
+        result <<= 1;
+    return result;
+}
+}
+
+//Slot's sequence equal to producer's index means it's free for that producer,
+//equal to index + 1 means message is written and can be delivered
+struct AsyncLogger::Slot
+{
+    std::atomic<size_t> sequence;
+    LogLevel            level;
+    std::string         message;
+};
+
+AsyncLogger::AsyncLogger(std::shared_ptr<ILogger> targetLogger, size_t minCapacity)
+    : writeIndex(0), readIndex(0), droppedCount(0), capacity(roundUpToPowerOfTwo(minCapacity)),
+      slots(new Slot[capacity]), target(std::move(targetLogger)), isStopping(false), isWorkerWaiting(false)
+{
+    for(size_t i = 0; i < capacity; ++i)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+
+    //Thread's start synchronizes with everything above, so worker never sees uninitialized slots
+    worker = std::thread(&AsyncLogger::run, this);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    {
+        std::lock_guard lock(mutex);
+        isStopping = true;
+    }
+    wakeUpCondition.notify_one();
+    worker.join();
+}
+
+void AsyncLogger::logAVMuxerMessage(const std::string& msg, LogLevel level)
+{
+    auto index = writeIndex.load(std::memory_order_relaxed);
+    Slot* slot;
+    while(true)
+    {
+        slot = &slots[index & (capacity - 1)];
+        auto diff = static_cast<intptr_t>(slot->sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(index);
+        if(diff == 0 && writeIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed))
+            break;
+        
+        if(diff < 0)
+        {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if(diff > 0)
+            index = writeIndex.load(std::memory_order_relaxed);
+    }
+
+    slot->level = level;
+    slot->message.assign(msg);
+    slot->sequence.store(index + 1, std::memory_order_release);
+
+    //Pairs with the fence in run() - either worker sees the message, or producer sees it's waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(isWorkerWaiting.load(std::memory_order_relaxed))
+    {
+        std::lock_guard lock(mutex);
+        wakeUpCondition.notify_one();
+    }
+}
+
+bool AsyncLogger::hasPendingMessage() const
+{
+    return slots[readIndex & (capacity - 1)].sequence.load(std::memory_order_acquire) == readIndex + 1;
+}
+
+void AsyncLogger::deliverPendingMessages()
+{
+    for(; hasPendingMessage(); ++readIndex)
+    {
+        auto& slot = slots[readIndex & (capacity - 1)];
+        try
+        {
+            if(target)
+                target->logAVMuxerMessage(slot.message, slot.level);
+        }
+        catch(...)
+        {
+            //There's nowhere to report logger's own failure to - message is lost
+        }
+
+        //Message's memory stays in the slot, so it's reused by next producer
+        slot.sequence.store(readIndex + capacity, std::memory_order_release);
+    }
+}
+
+void AsyncLogger::run()
+{
+    for(bool isLastRound = false; !isLastRound;)
+    {
+        deliverPendingMessages();
+        std::unique_lock lock(mutex);
+        isWorkerWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wakeUpCondition.wait(lock, [this] { return isStopping || hasPendingMessage(); });
+        isWorkerWaiting.store(false, std::memory_order_relaxed);
+        isLastRound = isStopping;
+    }
+    deliverPendingMessages();
+}
+}
@@ -1,5 +1,9 @@
+#include <algorithm>
+#include <stdexcept>
 
 #include "BaseMuxer.hpp"
+#include "MuxerException.hpp"
+#include "Tracing.hpp"
 #include "utils.hpp"
 
 namespace AVMuxer
@@ -9,10 +13,12 @@ namespace
     constexpr AVRational TIME_AHEAD_LIMIT_RATIO = { .num = 8, .den = 10};
 }
 
-BaseMuxer::BaseMuxer(const char* formatName)
-    : containerCtxt(std::make_shared<MediaContainerWrapper>(formatName)),
+BaseMuxer::BaseMuxer(const char* formatName, OutputSinkSharedPtr outputSink)
+    : containerCtxt(std::make_shared<MediaContainerWrapper>(formatName, outputSink)),
       timeAheadInCommonTimebaseLimit(0),
-      isMuxedDataAvailable(false), isContainerInitialized(false)
+      isMuxedDataAvailable(false), isContainerInitialized(false),
+      isBufferingTracked(false), isAboveHighWatermark(false), bufferedInputSize(0),
+      starvationTimeout(0)
 {}
 
 ByteVector BaseMuxer::getMuxedData()
@@ -21,9 +27,105 @@ ByteVector BaseMuxer::getMuxedData()
     return containerCtxt->getMuxedData();
 }
 
+size_t BaseMuxer::readMuxedData(uint8_t* dst, size_t capacity)
+{
+    auto readSize = containerCtxt->readMuxedData(dst, capacity);
+    isMuxedDataAvailable = containerCtxt->getMuxedDataSize() > 0;
+    return readSize;
+}
+
+void BaseMuxer::setContainerOptions(const ContainerOptions& options)
+{
+    containerCtxt->setOptions(options);
+}
+
+void BaseMuxer::addOutput(const char* formatName, OutputSinkSharedPtr outputSink, const ContainerOptions& options)
+{
+    containerCtxt->addMirrorOutput(formatName, outputSink, options);
+}
+
+void BaseMuxer::setBufferLimits(BufferLimits limits)
+{
+    if(isContainerInitialized)
+        throw MuxerException("Buffer limits can't be set once muxing has started");
+    if(limits.highWatermark > 0 && limits.lowWatermark >= limits.highWatermark)
+        throw std::invalid_argument("Low watermark has to be below high watermark");
+
+    bufferLimits = std::move(limits);
+    isBufferingTracked = bufferLimits.streamBudget > 0 || bufferLimits.muxerBudget > 0 || bufferLimits.highWatermark > 0;
+    //Streams may have buffered some input while waiting to be probed
+    bufferedInputSize = isBufferingTracked ? getStreamsBufferedSize() : 0;
+}
+
+bool BaseMuxer::cutSegment()
+{
+    auto loggerScope = makeLoggerScope();
+    isMuxedDataAvailable |= containerCtxt->cutSegment();
+    return isMuxedDataAvailable;
+}
+
+bool BaseMuxer::finish()
+{
+    auto loggerScope = makeLoggerScope();
+    isMuxedDataAvailable |= containerCtxt->finish();
+    return isMuxedDataAvailable;
+}
+
+MuxerMetrics BaseMuxer::getMetrics() const
+{
+    return MuxerMetrics { packetsMuxed.get(), containerCtxt->getOutputBytesCount(), getStreamsMetrics() };
+}
+
 int BaseMuxer::muxMediaData(MediaStreamWrapper& mediaCtxt, const ByteArray& inputData)
 {
+    auto loggerScope = makeLoggerScope();
+    throwIfInputFinished(mediaCtxt, inputData.size);
+    auto previousBufferedSize = getStreamBufferedSize(mediaCtxt);
+    trackStarvation(mediaCtxt, inputData.size);
     mediaCtxt.fillBuffer(inputData);
+    auto packetsMuxedCnt = muxBufferedData(mediaCtxt);
+    updateBufferedInputSize(mediaCtxt, previousBufferedSize);
+    return packetsMuxedCnt;
+}
+
+int BaseMuxer::muxMediaData(MediaStreamWrapper& mediaCtxt, const SharedByteArray& inputData)
+{
+    auto loggerScope = makeLoggerScope();
+    throwIfInputFinished(mediaCtxt, inputData.size);
+    auto previousBufferedSize = getStreamBufferedSize(mediaCtxt);
+    trackStarvation(mediaCtxt, inputData.size);
+    mediaCtxt.attachBuffer(inputData);
+    auto packetsMuxedCnt = muxBufferedData(mediaCtxt);
+    updateBufferedInputSize(mediaCtxt, previousBufferedSize);
+    return packetsMuxedCnt;
+}
+
+int BaseMuxer::muxPacket(MediaStreamWrapper& mediaCtxt, const EncodedPacket& packet)
+{
+    auto loggerScope = makeLoggerScope();
+    throwIfInputFinished(mediaCtxt, packet.data.size);
+    auto previousBufferedSize = getStreamBufferedSize(mediaCtxt);
+    trackStarvation(mediaCtxt, packet.data.size);
+    mediaCtxt.queuePacket(packet);
+    auto packetsMuxedCnt = muxBufferedData(mediaCtxt);
+    updateBufferedInputSize(mediaCtxt, previousBufferedSize);
+    return packetsMuxedCnt;
+}
+
+int BaseMuxer::finishInput(MediaStreamWrapper& mediaCtxt)
+{
+    auto loggerScope = makeLoggerScope();
+    auto previousBufferedSize = getStreamBufferedSize(mediaCtxt);
+    mediaCtxt.markInputFinished();
+    mediaCtxt.finishInput();
+    auto packetsMuxedCnt = muxBufferedData(mediaCtxt);
+    updateBufferedInputSize(mediaCtxt, previousBufferedSize);
+    return packetsMuxedCnt;
+}
+
+int BaseMuxer::muxBufferedData(MediaStreamWrapper& mediaCtxt)
+{
+    AVMUXER_TRACE_SCOPE("muxBufferedData");
     if(!isContainerInitialized)
     {
         if(!(isContainerInitialized = mediaCtxt && *containerCtxt))
@@ -32,20 +134,113 @@ int BaseMuxer::muxMediaData(MediaStreamWrapper& mediaCtxt, const ByteArray& inpu
         timeAheadInCommonTimebaseLimit = containerCtxt->getMaxInterleaveDelta() * TIME_AHEAD_LIMIT_RATIO.num / TIME_AHEAD_LIMIT_RATIO.den;
     }
 
-    if(shouldStreamBeLimited(mediaCtxt))
+    if(isStreamHeldBack(mediaCtxt))
+    {
+        mediaCtxt.countLimiting();
         return 0;
+    }
     
     int packetsMuxedCnt = 0;
+    bool isHeldBack = false;
     auto timebase = mediaCtxt.getTimeBase();
     for(auto packet = mediaCtxt.getNextFrame(); isPacketValid(packet); packet = mediaCtxt.getNextFrame())
     {
         auto diffInCommonTimebase = av_rescale_q(packet.duration, timebase, AV_TIME_BASE_Q);
         isMuxedDataAvailable |= containerCtxt->muxFramePacket(std::move(packet));
         ++packetsMuxedCnt;
+        mediaCtxt.countMuxedPacket();
         updateStreamRelativeTimeAhead(mediaCtxt, diffInCommonTimebase);
-        if(shouldStreamBeLimited(mediaCtxt))
+        if(isHeldBack = isStreamHeldBack(mediaCtxt); isHeldBack)
+        {
+            mediaCtxt.countLimiting();
             break;
+        }
     }
+
+    if(!isHeldBack && mediaCtxt.isInputFinished() && !mediaCtxt.isStalled())
+        leaveInterleaving(mediaCtxt);
+    packetsMuxed.add(packetsMuxedCnt);
     return packetsMuxedCnt;
 }
+
+bool BaseMuxer::wouldExceedBudget(MediaStreamWrapper& mediaCtxt, size_t inputSize)
+{
+    //Applies to every stream, also before header is written - muxer may wait for a stream that never gets data
+    if(!isBufferingTracked)
+        return false;
+
+    auto exceeds = [inputSize](size_t bufferedSize, size_t budget) { return budget > 0 && bufferedSize + inputSize > budget; };
+    return exceeds(mediaCtxt.getBufferedDataSize(), bufferLimits.streamBudget) || exceeds(bufferedInputSize, bufferLimits.muxerBudget);
+}
+
+bool BaseMuxer::isStreamStarved(const MediaStreamWrapper& mediaCtxt, std::chrono::steady_clock::time_point now) const
+{
+    //Streams which haven't received anything yet are given the time since muxer's first input
+    auto lastInputTime = std::max(mediaCtxt.getLastInputTime(), firstInputTime);
+    return !mediaCtxt.isStalled() && now - lastInputTime > starvationTimeout;
+}
+
+bool BaseMuxer::isStreamHeldBack(MediaStreamWrapper& mediaCtxt)
+{
+    if(!shouldStreamBeLimited(mediaCtxt))
+        return false;
+
+    if(starvationTimeout.count() == 0 || !excludeStalledStreams())
+        return true;
+
+    log(LogLevel::WARNING, "BaseMuxer - stream(s) not receiving data for over ", starvationTimeout.count(), " ms left out of interleaving");
+    return shouldStreamBeLimited(mediaCtxt);
+}
+
+void BaseMuxer::trackStarvation(MediaStreamWrapper& mediaCtxt, size_t inputSize)
+{
+    if(starvationTimeout.count() == 0 || inputSize == 0)
+        return;
+
+    auto now = getCurrentTime();
+    if(firstInputTime == std::chrono::steady_clock::time_point {})
+        firstInputTime = now;
+
+    mediaCtxt.markInputReceived(now);
+    if(mediaCtxt.isStalled())
+    {
+        rejoinStream(mediaCtxt);
+        log(LogLevel::INFO, "BaseMuxer - stream receives data again and rejoins interleaving");
+    }
+}
+
+void BaseMuxer::throwIfInputFinished(const MediaStreamWrapper& mediaCtxt, size_t inputSize) const
+{
+    if(inputSize > 0 && mediaCtxt.isInputFinished())
+        throw MuxerException("No more data can be muxed for stream once its input is finished");
+}
+
+size_t BaseMuxer::getStreamBufferedSize(MediaStreamWrapper& mediaCtxt) const
+{
+    return isBufferingTracked ? mediaCtxt.getBufferedDataSize() : 0;
+}
+
+void BaseMuxer::updateBufferedInputSize(MediaStreamWrapper& mediaCtxt, size_t previousStreamBufferedSize)
+{
+    if(!isBufferingTracked)
+        return;
+
+    //Only buffer of the stream that's just been muxed could have changed
+    bufferedInputSize = bufferedInputSize - previousStreamBufferedSize + mediaCtxt.getBufferedDataSize();
+    if(bufferLimits.highWatermark == 0)
+        return;
+
+    if(!isAboveHighWatermark && bufferedInputSize >= bufferLimits.highWatermark)
+    {
+        isAboveHighWatermark = true;
+        if(bufferLimits.onHighWatermark)
+            bufferLimits.onHighWatermark();
+    }
+    else if(isAboveHighWatermark && bufferedInputSize <= bufferLimits.lowWatermark)
+    {
+        isAboveHighWatermark = false;
+        if(bufferLimits.onLowWatermark)
+            bufferLimits.onLowWatermark();
+    }
+}
 }
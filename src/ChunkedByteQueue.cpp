@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <utility>
+
+#include "ChunkedByteQueue.hpp"
+
+namespace AVMuxer
+{
+ChunkedByteQueue::ChunkedByteQueue(size_t maxPooledChunksCount)
+    : head(nullptr), tail(nullptr), chunkPool(maxPooledChunksCount), queuedSize(0)
+{}
+
+ChunkedByteQueue::~ChunkedByteQueue()
+{
+    while(head != nullptr)
+        delete std::exchange(head, head->next);
+}
+
+void ChunkedByteQueue::append(const uint8_t* data, size_t dataSize)
+{
+    queuedSize += dataSize;
+    while(dataSize > 0)
+    {
+        if(tail == nullptr || tail->end == CHUNK_SIZE)
+        {
+            auto chunk = acquireChunk();
+            (tail == nullptr ? head : tail->next) = chunk;
+            tail = chunk;
+        }
+
+        auto copySize = std::min(dataSize, CHUNK_SIZE - tail->end);
+        std::copy_n(data, copySize, tail->data + tail->end);
+        tail->end += copySize;
+        data += copySize;
+        dataSize -= copySize;
+    }
+}
+
+size_t ChunkedByteQueue::read(uint8_t* dst, size_t capacity)
+{
+    size_t readSize = 0;
+    while(head != nullptr && readSize < capacity)
+    {
+        auto copySize = std::min(capacity - readSize, head->end - head->begin);
+        std::copy_n(head->data + head->begin, copySize, dst + readSize);
+        head->begin += copySize;
+        readSize += copySize;
+        if(head->begin == head->end)
+        {
+            auto drained = std::exchange(head, head->next);
+            if(head == nullptr)
+                tail = nullptr;
+            chunkPool.release(drained);
+        }
+    }
+
+    queuedSize -= readSize;
+    return readSize;
+}
+
+ChunkedByteQueue::Chunk* ChunkedByteQueue::acquireChunk()
+{
+    auto chunk = chunkPool.acquire();
+    chunk->begin = chunk->end = 0;
+    return chunk;
+}
+}
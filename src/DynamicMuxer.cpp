@@ -0,0 +1,174 @@
+#include <chrono>
+#include <stdexcept>
+
+#include "DynamicMuxer.hpp"
+#include "MuxerException.hpp"
+
+namespace AVMuxer
+{
+DynamicMuxer::DynamicMuxer(const char* formatName, OutputSinkSharedPtr outputSink)
+    : BaseMuxer(formatName, outputSink)
+{}
+
+unsigned DynamicMuxer::addStream()
+{
+    throwIfMuxingStarted();
+    return addCreatedStream(containerCtxt->createStream());
+}
+
+unsigned DynamicMuxer::addStream(const StreamProbeHints& probeHints)
+{
+    auto index = addStream();
+    streams[index]->setProbeHints(probeHints);
+    return index;
+}
+
+unsigned DynamicMuxer::addStream(AVRational framerate)
+{
+    if(framerate.num <= 0 || framerate.den <= 0)
+        throw std::invalid_argument("Framerate can't be zero");
+
+    throwIfMuxingStarted();
+    return addCreatedStream(containerCtxt->createStream(framerate));
+}
+
+unsigned DynamicMuxer::addStream(AVRational framerate, const StreamProbeHints& probeHints)
+{
+    auto index = addStream(framerate);
+    streams[index]->setProbeHints(probeHints);
+    return index;
+}
+
+bool DynamicMuxer::muxMediaData(unsigned streamIndex, const SharedByteArray& inputData)
+{
+    BaseMuxer::muxMediaData(*streams.at(streamIndex), inputData);
+    return hasMuxedData();
+}
+
+TryMuxResult DynamicMuxer::tryMuxMediaData(unsigned streamIndex, const SharedByteArray& inputData)
+{
+    if(wouldExceedBudget(*streams.at(streamIndex), inputData.size))
+        return TryMuxResult::WOULD_EXCEED_BUDGET;
+
+    muxMediaData(streamIndex, inputData);
+    return TryMuxResult::ACCEPTED;
+}
+
+bool DynamicMuxer::finishInput(unsigned streamIndex)
+{
+    BaseMuxer::finishInput(*streams.at(streamIndex));
+    return hasMuxedData();
+}
+
+void DynamicMuxer::setCodecParameters(unsigned streamIndex, const CodecParameters& params)
+{
+    auto loggerScope = makeLoggerScope();
+    streams.at(streamIndex)->setCodecParameters(params);
+}
+
+bool DynamicMuxer::muxPacket(unsigned streamIndex, const uint8_t* data, size_t size, int64_t pts, int64_t dts, bool isKeyframe, int64_t duration)
+{
+    BaseMuxer::muxPacket(*streams.at(streamIndex), EncodedPacket { {data, size}, pts, dts, duration, isKeyframe });
+    return hasMuxedData();
+}
+
+void DynamicMuxer::setMaxPooledInputBufferSize(size_t maxPooledSize)
+{
+    for(auto& stream : streams)
+        stream->setMaxPooledBufferSize(maxPooledSize);
+}
+
+void DynamicMuxer::setInputBufferSpilling(size_t thresholdSize, const std::string& directory)
+{
+    for(auto& stream : streams)
+        stream->setBufferSpilling(thresholdSize, directory);
+}
+
+bool DynamicMuxer::flush()
+{
+    ByteVector dummy;
+    for(auto& stream : streams)
+        BaseMuxer::muxMediaData(*stream, ByteArray { dummy.data(), dummy.size() });
+
+    return hasMuxedData();
+}
+
+void DynamicMuxer::updateStreamRelativeTimeAhead(MediaStreamWrapper& mediaCtxt, int64_t diff)
+{
+    //Stream's time ahead is absolute here, relative one is its distance from the slowest stream
+    if(auto timeAhead = mediaCtxt.getRelativeTimeAhead(); !mediaCtxt.isStalled())
+    {
+        streamsTimeAhead.erase(streamsTimeAhead.find(timeAhead));
+        streamsTimeAhead.insert(timeAhead + diff);
+    }
+    mediaCtxt.updateRelativeTimeAhead(diff);
+}
+
+bool DynamicMuxer::shouldStreamBeLimited(MediaStreamWrapper& mediaCtxt)
+{
+    if(mediaCtxt.isStalled() || streamsTimeAhead.empty())
+        return false;
+
+    return mediaCtxt.getRelativeTimeAhead() - *streamsTimeAhead.begin() > timeAheadInCommonTimebaseLimit;
+}
+
+bool DynamicMuxer::excludeStalledStreams()
+{
+    auto now = getCurrentTime();
+    bool isAnyStreamExcluded = false;
+    for(auto& stream : streams)
+    {
+        if(isStreamStarved(*stream, now))
+        {
+            leaveInterleaving(*stream);
+            isAnyStreamExcluded = true;
+        }
+    }
+    return isAnyStreamExcluded;
+}
+
+void DynamicMuxer::rejoinStream(MediaStreamWrapper& mediaCtxt)
+{
+    //Stream which fell behind while stalled resumes along with the slowest active one, instead of holding others back
+    if(!streamsTimeAhead.empty() && mediaCtxt.getRelativeTimeAhead() < *streamsTimeAhead.begin())
+        mediaCtxt.updateRelativeTimeAhead(*streamsTimeAhead.begin() - mediaCtxt.getRelativeTimeAhead());
+    streamsTimeAhead.insert(mediaCtxt.getRelativeTimeAhead());
+    mediaCtxt.setStalled(false);
+}
+
+void DynamicMuxer::leaveInterleaving(MediaStreamWrapper& mediaCtxt)
+{
+    streamsTimeAhead.erase(streamsTimeAhead.find(mediaCtxt.getRelativeTimeAhead()));
+    mediaCtxt.setStalled(true);
+}
+
+std::vector<StreamMetrics> DynamicMuxer::getStreamsMetrics() const
+{
+    std::vector<StreamMetrics> metrics;
+    metrics.reserve(streams.size());
+    for(const auto& stream : streams)
+        metrics.push_back(stream->getMetrics());
+    return metrics;
+}
+
+size_t DynamicMuxer::getStreamsBufferedSize() const
+{
+    size_t bufferedSize = 0;
+    for(const auto& stream : streams)
+        bufferedSize += stream->getBufferedDataSize();
+    return bufferedSize;
+}
+
+void DynamicMuxer::throwIfMuxingStarted() const
+{
+    if(isMuxingStarted())
+        throw MuxerException("Can't add stream after muxing has started");
+}
+
+unsigned DynamicMuxer::addCreatedStream(WrappedMediaStreamSharedPtr stream)
+{
+    streamsTimeAhead.insert(stream->getRelativeTimeAhead());
+    streams.push_back(std::move(stream));
+    return streams.size() - 1;
+}
+}
@@ -0,0 +1,328 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "FileSink.hpp"
+#include "MuxerException.hpp"
+
+extern "C"
+{
+    #include <libavutil/error.h>
+}
+
+namespace AVMuxer
+{
+namespace
+{
+constexpr size_t MAX_POOLED_BATCHES = 4;
+//Files are spread over writer threads, so slow write or sync of one file holds back only files sharing its thread
+constexpr unsigned MAX_WRITER_THREADS = 4;
+}
+
+struct FileSink::Batch
+{
+    std::unique_ptr<uint8_t[]> data;
+    size_t                     size;
+    uint64_t                   offset;
+    bool                       shouldSync;
+};
+
+//Shared by sink and writer thread; written batches are given back to sink for reuse
+struct FileSink::FileState
+{
+    int                                 fd;
+    size_t                              batchCapacity;
+    std::mutex                          mutex;
+    std::condition_variable             writtenCondition;
+    size_t                              pendingSize = 0;
+    size_t                              pendingBatchesCount = 0;
+    bool                                isAboveHighWatermark = false;
+    size_t                              lowWatermark = 0;
+    std::function<void()>               onLowWatermark;
+    std::atomic<int>                    error = 0;
+    std::vector<std::unique_ptr<Batch>> pooledBatches;
+
+    ~FileState()
+    {
+        close(fd);
+    }
+
+    std::unique_ptr<Batch> acquireBatch()
+    {
+        {
+            std::lock_guard lock(mutex);
+            if(!pooledBatches.empty())
+            {
+                auto batch = std::move(pooledBatches.back());
+                pooledBatches.pop_back();
+                return batch;
+            }
+        }
+
+        return std::unique_ptr<Batch>(new Batch { std::unique_ptr<uint8_t[]>(new uint8_t[batchCapacity]), 0, 0, false });
+    }
+};
+
+namespace
+{
+struct WriteJob
+{
+    std::shared_ptr<FileSink::FileState> file;
+    std::unique_ptr<FileSink::Batch>     batch;
+};
+
+//Thread writing batches of its share of file sinks, in order they were submitted
+class WriterThread
+{
+    public:
+        WriterThread() = default;
+        WriterThread(const WriterThread&) = delete;
+        WriterThread& operator=(const WriterThread&) = delete;
+
+        ~WriterThread()
+        {
+            {
+                std::lock_guard lock(mutex);
+                isStopping = true;
+            }
+            wakeUpCondition.notify_one();
+            worker.join();
+        }
+
+        void enqueue(WriteJob&& job)
+        {
+            {
+                std::lock_guard lock(mutex);
+                jobs.push_back(std::move(job));
+            }
+            wakeUpCondition.notify_one();
+        }
+
+    private:
+        std::mutex              mutex;
+        std::condition_variable wakeUpCondition;
+        std::deque<WriteJob>    jobs;
+        bool                    isStopping = false;
+        //Declared last, so worker starts once everything else is constructed
+        std::thread             worker { &WriterThread::run, this };
+
+        void run()
+        {
+            std::deque<WriteJob> currentJobs;
+            while(true)
+            {
+                {
+                    std::unique_lock lock(mutex);
+                    wakeUpCondition.wait(lock, [this] { return isStopping || !jobs.empty(); });
+                    if(jobs.empty())
+                        return;
+                    currentJobs.swap(jobs);
+                }
+
+                while(!currentJobs.empty())
+                    writeContiguousJobs(currentJobs);
+            }
+        }
+
+        //Takes jobs of the same file which batches follow each other in it, and writes them with single call
+        void writeContiguousJobs(std::deque<WriteJob>& pendingJobs)
+        {
+            std::vector<WriteJob> group;
+            std::vector<iovec> vectors;
+            do
+            {
+                auto& batch = *pendingJobs.front().batch;
+                vectors.push_back(iovec { batch.data.get(), batch.size });
+                group.push_back(std::move(pendingJobs.front()));
+                pendingJobs.pop_front();
+            }
+            while(!pendingJobs.empty() && vectors.size() < IOV_MAX && pendingJobs.front().file == group.front().file
+                  && pendingJobs.front().batch->offset == group.back().batch->offset + group.back().batch->size);
+
+            auto& file = *group.front().file;
+            auto error = (file.error.load(std::memory_order_relaxed) == 0 ? writeVectors(file.fd, vectors, group.front().batch->offset) : 0);
+            bool shouldSync = std::any_of(group.begin(), group.end(), [](const auto& job) { return job.batch->shouldSync; });
+            if(error == 0 && shouldSync && fdatasync(file.fd) < 0)
+                error = AVERROR(errno);
+
+            std::lock_guard lock(file.mutex);
+            if(error != 0)
+                file.error.store(error, std::memory_order_relaxed);
+            for(auto& job : group)
+            {
+                file.pendingSize -= job.batch->size;
+                --file.pendingBatchesCount;
+                if(file.pooledBatches.size() < MAX_POOLED_BATCHES)
+                    file.pooledBatches.push_back(std::move(job.batch));
+            }
+            //Called under lock, so it can't overtake high watermark callback of the batch submitted meanwhile
+            if(file.isAboveHighWatermark && file.pendingSize <= file.lowWatermark)
+            {
+                file.isAboveHighWatermark = false;
+                if(file.onLowWatermark)
+                    file.onLowWatermark();
+            }
+            file.writtenCondition.notify_all();
+        }
+
+        static int writeVectors(int fd, std::vector<iovec>& vectors, uint64_t offset)
+        {
+            for(auto current = vectors.begin(); current != vectors.end();)
+            {
+                auto result = pwritev(fd, &*current, vectors.end() - current, offset);
+                if(result < 0 && errno == EINTR)
+                    continue;
+                if(result < 0)
+                    return AVERROR(errno);
+
+                //Partial write - skip what's been written and retry with the rest
+                offset += result;
+                size_t written = result;
+                for(; current != vectors.end() && written >= current->iov_len; ++current)
+                    written -= current->iov_len;
+                if(written > 0)
+                {
+                    current->iov_base = static_cast<uint8_t*>(current->iov_base) + written;
+                    current->iov_len -= written;
+                }
+            }
+            return 0;
+        }
+};
+
+//Writer threads shared by all file sinks; each file is always written by the same thread, so its batches stay in order
+class FileWriter
+{
+    public:
+        static FileWriter& getInstance()
+        {
+            static FileWriter writer;
+            return writer;
+        }
+
+        void enqueue(WriteJob&& job)
+        {
+            auto& thread = *threads[job.file->fd % threads.size()];
+            thread.enqueue(std::move(job));
+        }
+
+    private:
+        std::vector<std::unique_ptr<WriterThread>> threads;
+
+        FileWriter()
+        {
+            auto threadsCount = std::clamp(std::thread::hardware_concurrency(), 1u, MAX_WRITER_THREADS);
+            for(unsigned i = 0; i < threadsCount; ++i)
+                threads.push_back(std::make_unique<WriterThread>());
+        }
+};
+}
+
+FileSink::FileSink(const std::string& path, const FileSinkOptions& sinkOptions)
+    : options(sinkOptions), fileOffset(0)
+{
+    if(options.highWatermark > 0 && options.lowWatermark >= options.highWatermark)
+        throw std::invalid_argument("Low watermark has to be below high watermark");
+
+    //Batches cut at segment and chunk ends are partial, so file offsets of later ones aren't page-aligned anyway;
+    //writes go through page cache, so batch size only needs to be big enough to make few syscalls
+    options.batchSize = std::max<size_t>(options.batchSize, PAGE_SIZE);
+    auto fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0)
+        throw MuxerException("Couldn't open output file " + path + ": " + std::strerror(errno));
+
+    state = std::make_shared<FileState>();
+    state->fd = fd;
+    state->batchCapacity = options.batchSize;
+    state->lowWatermark = options.lowWatermark;
+    state->onLowWatermark = std::move(options.onLowWatermark);
+    currentBatch = state->acquireBatch();
+    FileWriter::getInstance();
+}
+
+FileSink::~FileSink()
+{
+    auto result = flush(options.fsyncPolicy != FsyncPolicy::NEVER);
+    if(result < 0)
+        log(LogLevel::ERROR, "FileSink - writing output file failed with error: ", AvErrorCode { result });
+}
+
+int FileSink::write(const uint8_t* data, int size)
+{
+    if(auto error = state->error.load(std::memory_order_relaxed); error != 0)
+        return error;
+
+    for(int copied = 0; copied < size;)
+    {
+        auto copySize = std::min<size_t>(size - copied, options.batchSize - currentBatch->size);
+        std::copy_n(data + copied, copySize, currentBatch->data.get() + currentBatch->size);
+        currentBatch->size += copySize;
+        copied += copySize;
+        if(currentBatch->size == options.batchSize)
+            submitBatch(options.fsyncPolicy == FsyncPolicy::EVERY_BATCH);
+    }
+    return size;
+}
+
+void FileSink::closeSegment(const SegmentInfo&)
+{
+    submitBatch(options.fsyncPolicy == FsyncPolicy::EVERY_SEGMENT || options.fsyncPolicy == FsyncPolicy::EVERY_BATCH);
+}
+
+void FileSink::closeChunk(const SegmentInfo&)
+{
+    submitBatch(options.fsyncPolicy == FsyncPolicy::EVERY_BATCH);
+}
+
+int FileSink::flush(bool shouldSync)
+{
+    if(currentBatch->size > 0 || shouldSync)
+        submitBatch(shouldSync);
+
+    std::unique_lock lock(state->mutex);
+    state->writtenCondition.wait(lock, [this] { return state->pendingBatchesCount == 0; });
+    return state->error.load(std::memory_order_relaxed);
+}
+
+void FileSink::submitBatch(bool shouldSync)
+{
+    if(currentBatch->size == 0 && !shouldSync)
+        return;
+
+    {
+        //Backpressure - waits only if writer is far behind
+        std::unique_lock lock(state->mutex);
+        state->writtenCondition.wait(lock, [this]
+        {
+            return state->pendingSize == 0 || state->pendingSize + currentBatch->size <= options.maxPendingSize;
+        });
+        state->pendingSize += currentBatch->size;
+        ++state->pendingBatchesCount;
+        if(options.highWatermark > 0 && !state->isAboveHighWatermark && state->pendingSize >= options.highWatermark)
+        {
+            state->isAboveHighWatermark = true;
+            if(options.onHighWatermark)
+                options.onHighWatermark();
+        }
+    }
+
+    currentBatch->offset = fileOffset;
+    currentBatch->shouldSync = shouldSync;
+    fileOffset += currentBatch->size;
+    FileWriter::getInstance().enqueue(WriteJob { state, std::move(currentBatch) });
+    currentBatch = state->acquireBatch();
+    currentBatch->size = 0;
+}
+}
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFile.hpp"
+#include "MuxerException.hpp"
+#include "utils.hpp"
+
+namespace AVMuxer
+{
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path)
+{
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+        throw MuxerException("Couldn't open input file " + path + ": " + std::strerror(errno));
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) < 0)
+    {
+        auto errNr = errno;
+        close(fd);
+        throw MuxerException("Couldn't read size of input file " + path + ": " + std::strerror(errNr));
+    }
+
+    //Mapping stays valid after file is closed; empty file has no mapping at all
+    size_t fileSize = fileStat.st_size;
+    void* mapping = nullptr;
+    if(fileSize > 0 && (mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+    {
+        auto errNr = errno;
+        close(fd);
+        throw MuxerException("Couldn't map input file " + path + ": " + std::strerror(errNr));
+    }
+
+    close(fd);
+    if(mapping != nullptr)
+        madvise(mapping, fileSize, MADV_SEQUENTIAL);
+    return std::shared_ptr<MappedFile>(new MappedFile(static_cast<uint8_t*>(mapping), fileSize));
+}
+
+MappedFile::MappedFile(uint8_t* fileMapping, size_t mappedSize) : mapping(fileMapping), fileSize(mappedSize)
+{}
+
+MappedFile::~MappedFile()
+{
+    if(mapping != nullptr)
+        munmap(mapping, fileSize);
+}
+
+SharedByteArray MappedFile::getData(size_t offset, size_t size) const
+{
+    offset = std::min(offset, fileSize);
+    size = std::min(size, fileSize - offset);
+    std::shared_ptr<const void> owner(mapping + offset, [file = shared_from_this(), offset, size](const void*)
+    {
+        file->releasePages(offset, size);
+    });
+    return SharedByteArray(mapping + offset, size, std::move(owner));
+}
+
+void MappedFile::releasePages(size_t offset, size_t size) const
+{
+    //Only pages that lie entirely within released part are dropped, as neighbouring parts may still be read
+    auto begin = (offset + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    auto end = (offset + size == fileSize ? fileSize : (offset + size) / PAGE_SIZE * PAGE_SIZE);
+    if(begin < end)
+        madvise(mapping + begin, end - begin, MADV_DONTNEED);
+}
+}
@@ -1,35 +1,102 @@
 #include <algorithm>
+#include <stdexcept>
+#include <string>
 
 #include "MediaContainerContext.hpp"
 #include "MuxerException.hpp"
+#include "Tracing.hpp"
 #include "utils.hpp"
 
 namespace AVMuxer
 {
+namespace
+{
+    constexpr auto STREAMING_MOVFLAGS        = "frag_keyframe+empty_moov+default_base_moof";
+    //Fragments are written only when segment or chunk is cut
+    constexpr auto CUSTOM_FRAGMENTS_MOVFLAGS = "frag_custom+empty_moov+default_base_moof";
+    constexpr auto MOVFLAGS_KEY              = "movflags";
+
+    bool isMp4(const AVFormatContext* formatCtxt)
+    {
+        return std::string("mp4") == formatCtxt->oformat->name;
+    }
+
+    const std::string* findFormatOption(const ContainerOptions& options, const std::string& key)
+    {
+        auto option = std::find_if(options.formatOptions.begin(), options.formatOptions.end(), [&key](const auto& current)
+        {
+            return current.first == key;
+        });
+        return option != options.formatOptions.end() ? &option->second : nullptr;
+    }
+
+    //Flags are joined with '+' (each one may also be prefixed with '+' or '-', setting or clearing it)
+    bool isFlagSet(const std::string& flags, const std::string& flag)
+    {
+        bool isSet = false;
+        for(size_t begin = 0; begin < flags.size();)
+        {
+            auto prefix = flags[begin];
+            if(prefix == '+' || prefix == '-')
+                ++begin;
+            auto end = std::min(flags.find_first_of("+-", begin), flags.size());
+            if(flags.compare(begin, end - begin, flag) == 0)
+                isSet = prefix != '-';
+            begin = end;
+        }
+        return isSet;
+    }
+
+    //Packet passed to muxer is left blank, so this releases it only if muxing failed before that
+    class PacketUnrefGuard
+    {
+        public:
+            explicit PacketUnrefGuard(AVPacket& guardedPacket) : packet(guardedPacket)
+            {}
+
+            ~PacketUnrefGuard()
+            {
+                av_packet_unref(&packet);
+            }
+
+            PacketUnrefGuard(const PacketUnrefGuard&) = delete;
+            PacketUnrefGuard& operator=(const PacketUnrefGuard&) = delete;
+
+        private:
+            AVPacket& packet;
+    };
+}
+
 int muxCallback(void* opaque, uint8_t* buf, int bufSize)
 {
+    AVMUXER_TRACE_SCOPE("outputSinkWrite");
     auto muxer = reinterpret_cast<MediaContainerContext*>(opaque);
-    ByteVector &outputData = muxer->muxedMediaData;
-    outputData.insert(outputData.end(), buf, buf + bufSize); //todo: some data allocation optimization would be cool
-    return bufSize;
+    auto result = muxer->outputSink->write(buf, bufSize);
+    if(result > 0)
+        muxer->outputBytesCount.add(result);
+    return result;
 }
 
-MediaContainerContext::MediaContainerContext(const char* formatName)
-    : ioCtxt(this, nullptr, muxCallback)
+constexpr IoProcedures CONTAINER_IO_PROCEDURES { nullptr, muxCallback, nullptr };
+
+MediaContainerContext::MediaContainerContext(const char* formatName, OutputSinkSharedPtr sink)
+    : outputSink(sink ? sink : std::make_shared<ChunkedBufferSink>()),
+      ioCtxt(this, CONTAINER_IO_PROCEDURES),
+      segmentReferenceStream(0), segmentStartTime(AV_NOPTS_VALUE), segmentEndTime(AV_NOPTS_VALUE),
+      chunkStartTime(AV_NOPTS_VALUE), segmentsCount(0), chunksCount(0), isFinished(false)
 {
-    log("Creating MediaStreamContext instance", LogLevel::DEBUG);
+    log(LogLevel::DEBUG, "Creating MediaStreamContext instance");
 
     auto result = avformat_alloc_output_context2(&formatCtxt, nullptr, formatName, nullptr);
     if(result < 0)
         throw MuxerException("Couldn't initialize format context; the error was: " + getAvErrorString(result));
-    formatCtxt->pb = ioCtxt;
     formatCtxt->opaque = nullptr;
     formatCtxt->strict_std_compliance = FF_COMPLIANCE_EXPERIMENTAL;
 }
 
 MediaContainerContext::~MediaContainerContext()
 {
-    log("Deleting MediaStreamContext instance", LogLevel::DEBUG);
+    log(LogLevel::DEBUG, "Deleting MediaStreamContext instance");
     if(formatCtxt != nullptr)
         avformat_free_context(formatCtxt);
 }
@@ -39,7 +106,7 @@ MediaStreamSharedPtr MediaContainerContext::createStream(AVRational framerate)
     auto stream = avformat_new_stream(formatCtxt, nullptr);
     if(stream == nullptr)
     {
-        log("Failed at creating media stream", LogLevel::ERROR);
+        log(LogLevel::ERROR, "Failed at creating media stream");
         throw MuxerException("Couldn't initialize media stream");
     }
 
@@ -47,19 +114,106 @@ MediaStreamSharedPtr MediaContainerContext::createStream(AVRational framerate)
     return streamCtxts.emplace_back(std::make_shared<MediaStreamContext>(stream));
 }
 
+void MediaContainerContext::addMirrorOutput(const char* formatName, OutputSinkSharedPtr sink, const ContainerOptions& mirrorOptions)
+{
+    if(formatCtxt->opaque)
+        throw MuxerException("Outputs can't be added after header is written");
+    if(!sink)
+        throw std::invalid_argument("Additional output needs its own sink");
+
+    auto& mirror = mirrors.emplace_back(std::make_unique<MediaContainerContext>(formatName, sink));
+    mirror->setOptions(mirrorOptions);
+}
+
+void MediaContainerContext::setOptions(const ContainerOptions& containerOptions)
+{
+    if(formatCtxt->opaque)
+        throw MuxerException("Container options can't be changed after header is written");
+    //Chunks are parts of segments - without segments, they'd never be delivered as a whole
+    if(containerOptions.chunkDuration > 0 && containerOptions.segmentDuration <= 0)
+        throw std::invalid_argument("Chunking needs segmenting to be enabled as well");
+    //Otherwise mp4 muxer cuts fragments on its own (or only writes moov at the end), not along segments
+    if(auto movflags = findFormatOption(containerOptions, MOVFLAGS_KEY);
+       movflags && containerOptions.segmentDuration > 0 && isMp4(formatCtxt) && !isFlagSet(*movflags, "frag_custom"))
+        throw std::invalid_argument("Segmenting mp4 needs frag_custom in movflags");
+
+    options = containerOptions;
+    ioCtxt.setBufferSize(options.ioBufferSize);
+    //Interleaving window shouldn't hold packets back longer than chunk lasts
+    if(auto interleaveDelta = options.maxInterleaveDelta > 0 ? options.maxInterleaveDelta : options.chunkDuration; interleaveDelta > 0)
+        formatCtxt->max_interleave_delta = interleaveDelta;
+}
+
 bool MediaContainerContext::muxFramePacket(AVPacket&& packet)
 {
+    PacketUnrefGuard packetGuard(packet);
+    if(isFinished)
+        throw MuxerException("Packets can't be muxed once container is finished");
+    if(isFragmenting())
+    {
+        auto timebase = formatCtxt->streams[packet.stream_index]->time_base;
+        auto packetTime = av_rescale_q(packet.pts, timebase, AV_TIME_BASE_Q);
+        if(isSegmentBoundary(packet, packetTime))
+            closeSegment(packetTime);
+        else if(isChunkBoundary(packet, packetTime))
+            closeChunk(packetTime);
+
+        if(segmentStartTime == AV_NOPTS_VALUE)
+            segmentStartTime = segmentEndTime = packetTime;
+        if(chunkStartTime == AV_NOPTS_VALUE)
+            chunkStartTime = packetTime;
+        segmentEndTime = std::max(segmentEndTime, packetTime + av_rescale_q(packet.duration, timebase, AV_TIME_BASE_Q));
+    }
+
+    for(auto& mirror : mirrors)
+        mirror->muxMirroredPacket(packet, formatCtxt->streams[packet.stream_index]->time_base);
+
+    AVMUXER_TRACE_SCOPE("av_interleaved_write_frame");
     if(auto result = av_interleaved_write_frame(formatCtxt, &packet); result < 0)
         throw MuxerException("Couldn't mux media data; the error was: " + getAvErrorString(result));
     
-    return !muxedMediaData.empty();
+    return outputSink->hasPendingData();
+}
+
+//Ends current media segment right away, ie. when input is over; returns true if there's muxed data waiting
+bool MediaContainerContext::cutSegment()
+{
+    if(segmentStartTime != AV_NOPTS_VALUE)
+        closeSegment(segmentEndTime);
+
+    for(auto& mirror : mirrors)
+        mirror->cutSegment();
+    return outputSink->hasPendingData();
+}
+
+bool MediaContainerContext::finish()
+{
+    //Without header nothing has been written, so there's no trailer to write either
+    if(isFinished || !formatCtxt->opaque)
+        return outputSink->hasPendingData();
+
+    //Trailer writes packets still waiting for interleaving, then what's left of the container (ie. mp4's last
+    //fragment and fragment index), so it goes before last segment is closed and its data ends up in that segment
+    isFinished = true;
+    if(auto result = av_write_trailer(formatCtxt); result < 0)
+        throw MuxerException("Couldn't write container's trailer; the error was: " + getAvErrorString(result));
+    if(segmentStartTime != AV_NOPTS_VALUE)
+        closeSegment(segmentEndTime);
+    avio_flush(formatCtxt->pb);
+
+    for(auto& mirror : mirrors)
+        mirror->finish();
+    return outputSink->hasPendingData();
 }
 
 ByteVector MediaContainerContext::getMuxedData()
 {
-    ByteVector result;
-    result.swap(muxedMediaData);
-    return result;
+    return outputSink->takeData();
+}
+
+size_t MediaContainerContext::readMuxedData(uint8_t* dst, size_t capacity)
+{
+    return outputSink->read(dst, capacity);
 }
 
 bool MediaContainerContext::writeHeaderIfNeeded()
@@ -69,13 +223,110 @@ bool MediaContainerContext::writeHeaderIfNeeded()
     if(isHeaderWritten || std::any_of(streamCtxts.begin(), streamCtxts.end(), [] (const auto& stream) { return !*stream; }))
         return isHeaderWritten;
     
-    AVDictionary* options = nullptr;
-    if(std::string("mp4") == formatCtxt->oformat->name)
-        av_dict_set(&options, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
-    auto result = avformat_write_header(formatCtxt, &options);
+    AVDictionary* formatOptions = nullptr;
+    for(const auto& [key, value] : options.formatOptions)
+        av_dict_set(&formatOptions, key.c_str(), value.c_str(), 0);
+
+    if(isMp4(formatCtxt) && !findFormatOption(options, MOVFLAGS_KEY))
+        av_dict_set(&formatOptions, MOVFLAGS_KEY, isFragmenting() ? CUSTOM_FRAGMENTS_MOVFLAGS : STREAMING_MOVFLAGS, 0);
+    //I/O context (with its buffer) is created only now, when there's something to write
+    formatCtxt->pb = ioCtxt;
+    auto result = avformat_write_header(formatCtxt, &formatOptions);
+    av_dict_free(&formatOptions);
     if(result < 0)
         throw MuxerException("Couldn't write main header for container; the error was: " + getAvErrorString(result));
-    
+
+    if(isFragmenting())
+    {
+        //Segments are cut on first video stream's keyframes, as they're the ones decoding can start from;
+        //chunks are timed against the same stream, but don't have to start at keyframes
+        auto videoStream = std::find_if(formatCtxt->streams, formatCtxt->streams + formatCtxt->nb_streams, [](const auto* stream)
+        {
+            return stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO;
+        });
+        segmentReferenceStream = videoStream != formatCtxt->streams + formatCtxt->nb_streams ? (*videoStream)->index : 0;
+
+        avio_flush(formatCtxt->pb);
+        outputSink->closeSegment(SegmentInfo { .isInitSegment = true });
+    }
+
+    for(auto& mirror : mirrors)
+        mirror->initializeAsMirrorOf(formatCtxt);
     return (isHeaderWritten = true);
 }
+
+void MediaContainerContext::initializeAsMirrorOf(const AVFormatContext* sourceFormatCtxt)
+{
+    for(unsigned i = 0; i < sourceFormatCtxt->nb_streams; ++i)
+    {
+        auto source = sourceFormatCtxt->streams[i];
+        auto stream = avformat_new_stream(formatCtxt, nullptr);
+        if(stream == nullptr || avcodec_parameters_copy(stream->codecpar, source->codecpar) < 0)
+            throw MuxerException("Couldn't initialize mirrored media stream");
+
+        //Codec tags are container-specific, let the muxer pick its own one
+        stream->codecpar->codec_tag = 0;
+        stream->time_base = source->time_base;
+        stream->r_frame_rate = source->r_frame_rate;
+    }
+
+    writeHeaderIfNeeded();
+}
+
+void MediaContainerContext::muxMirroredPacket(const AVPacket& packet, AVRational sourceTimebase)
+{
+    //Only reference to packet's data is taken, it's not copied
+    AVPacket mirroredPacket;
+    av_init_packet(&mirroredPacket);
+    if(auto result = av_packet_ref(&mirroredPacket, &packet); result < 0)
+        throw MuxerException("Couldn't reference packet for mirrored output; the error was: " + getAvErrorString(result));
+
+    av_packet_rescale_ts(&mirroredPacket, sourceTimebase, formatCtxt->streams[packet.stream_index]->time_base);
+    muxFramePacket(std::move(mirroredPacket));
+}
+
+bool MediaContainerContext::isSegmentBoundary(const AVPacket& packet, int64_t packetTime) const
+{
+    return packet.stream_index == segmentReferenceStream && (packet.flags & AV_PKT_FLAG_KEY)
+           && segmentStartTime != AV_NOPTS_VALUE && packetTime - segmentStartTime >= options.segmentDuration;
+}
+
+bool MediaContainerContext::isChunkBoundary(const AVPacket& packet, int64_t packetTime) const
+{
+    return options.chunkDuration > 0 && packet.stream_index == segmentReferenceStream
+           && chunkStartTime != AV_NOPTS_VALUE && packetTime - chunkStartTime >= options.chunkDuration;
+}
+
+void MediaContainerContext::flushFragment()
+{
+    //Packets still waiting for interleaving belong to closed fragment, then muxer's buffered fragment is written out;
+    //once trailer is written, muxer holds nothing more
+    if(!isFinished)
+    {
+        if(auto result = av_interleaved_write_frame(formatCtxt, nullptr); result < 0)
+            throw MuxerException("Couldn't flush interleaved packets; the error was: " + getAvErrorString(result));
+        if(auto result = av_write_frame(formatCtxt, nullptr); result < 0)
+            throw MuxerException("Couldn't flush media fragment; the error was: " + getAvErrorString(result));
+    }
+    avio_flush(formatCtxt->pb);
+}
+
+void MediaContainerContext::closeChunk(int64_t endTime)
+{
+    flushFragment();
+    outputSink->closeChunk(SegmentInfo { false, segmentsCount + 1, chunksCount++, chunkStartTime, endTime - chunkStartTime });
+    chunkStartTime = AV_NOPTS_VALUE;
+}
+
+void MediaContainerContext::closeSegment(int64_t endTime)
+{
+    if(options.chunkDuration > 0)
+        closeChunk(endTime);
+    else
+        flushFragment();
+
+    outputSink->closeSegment(SegmentInfo { false, ++segmentsCount, 0, segmentStartTime, endTime - segmentStartTime });
+    segmentStartTime = segmentEndTime = AV_NOPTS_VALUE;
+    chunksCount = 0;
+}
 }
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <utility>
+
+#include "MediaDataQueue.hpp"
+
+namespace AVMuxer
+{
+MediaDataQueue::MediaDataQueue(size_t maxPooledSize)
+    : head(nullptr), tail(nullptr), readSegment(nullptr), readPos(0), readSize(0), queuedSize(0), discardedSize(0),
+      chunkPool(maxPooledSize / CHUNK_SIZE), segmentPool(MAX_POOLED_SEGMENTS)
+{}
+
+MediaDataQueue::~MediaDataQueue()
+{
+    while(head != nullptr)
+    {
+        auto segment = std::exchange(head, head->next);
+        if(segment->isAttached())
+            delete segment;
+        else
+            delete static_cast<Chunk*>(segment);
+    }
+}
+
+void MediaDataQueue::append(const ByteArray& data)
+{
+    auto src = data.begin();
+    auto leftToCopy = data.size;
+    while(leftToCopy > 0)
+    {
+        auto copySize = (spilling != nullptr && queuedSize >= spilling->threshold ? spill(src, leftToCopy) : 0);
+        if(copySize == 0)
+            copySize = appendToChunk(src, leftToCopy);
+
+        queuedSize += copySize;
+        src += copySize;
+        leftToCopy -= copySize;
+    }
+}
+
+void MediaDataQueue::attach(const SharedByteArray& data)
+{
+    if(data.empty())
+        return;
+
+    if(data.owner == nullptr)
+        return append(data);
+
+    auto segment = acquireSegment();
+    segment->data = data.data;
+    segment->end = data.size;
+    segment->owner = data.owner;
+    queuedSize += data.size;
+    pushBack(segment);
+}
+
+size_t MediaDataQueue::read(uint8_t* dst, size_t capacity)
+{
+    size_t copiedSize = 0;
+    while(readSegment != nullptr && copiedSize < capacity)
+    {
+        if(readPos == readSegment->end)
+        {
+            if(readSegment->next == nullptr)
+                break;
+
+            readSegment = readSegment->next;
+            readPos = readSegment->begin;
+            continue;
+        }
+
+        auto copySize = std::min(capacity - copiedSize, readSegment->end - readPos);
+        std::copy_n(readSegment->data + readPos, copySize, dst + copiedSize);
+        readPos += copySize;
+        copiedSize += copySize;
+    }
+
+    readSize += copiedSize;
+    return copiedSize;
+}
+
+void MediaDataQueue::rewind()
+{
+    readSegment = head;
+    readPos = (head != nullptr ? head->begin : 0);
+    readSize = 0;
+}
+
+bool MediaDataQueue::seek(uint64_t position)
+{
+    if(position < discardedSize || position > discardedSize + queuedSize)
+        return false;
+
+    rewind();
+    for(auto leftToSkip = position - discardedSize; leftToSkip > 0;)
+    {
+        if(readPos == readSegment->end)
+        {
+            readSegment = readSegment->next;
+            readPos = readSegment->begin;
+        }
+
+        auto skipSize = std::min<uint64_t>(leftToSkip, readSegment->end - readPos);
+        readPos += skipSize;
+        readSize += skipSize;
+        leftToSkip -= skipSize;
+    }
+    return true;
+}
+
+void MediaDataQueue::discardUntil(uint64_t position)
+{
+    if(position <= discardedSize)
+        return;
+
+    auto leftToDiscard = std::min<uint64_t>(position, getReadPosition()) - discardedSize;
+    discardedSize += leftToDiscard;
+    queuedSize -= leftToDiscard;
+    readSize -= leftToDiscard;
+    while(leftToDiscard > 0 || (head != readSegment && head->begin == head->end))
+    {
+        auto discardSize = std::min<uint64_t>(leftToDiscard, head->end - head->begin);
+        head->begin += discardSize;
+        leftToDiscard -= discardSize;
+        if(head->begin < head->end || head == readSegment)
+            continue;
+
+        release(std::exchange(head, head->next));
+    }
+
+    if(head == nullptr || head != readSegment || head->begin < head->end)
+        return;
+
+    if(head == tail && !head->isAttached())
+    {
+        //Last chunk is fully read - reuse it instead of pooling it
+        head->begin = head->end = readPos = 0;
+        return;
+    }
+
+    release(std::exchange(head, head->next));
+    if(head == nullptr)
+        tail = nullptr;
+    readSegment = head;
+    readPos = (head != nullptr ? head->begin : 0);
+}
+
+void MediaDataQueue::setMaxPooledSize(size_t maxPooledSize)
+{
+    chunkPool.setMaxPooledCount(maxPooledSize / CHUNK_SIZE);
+}
+
+void MediaDataQueue::setSpilling(size_t thresholdSize, const std::string& directory)
+{
+    if(thresholdSize == 0)
+    {
+        //Data that's already spilled keeps the file alive until it's discarded
+        spilling.reset();
+        return;
+    }
+
+    if(spilling == nullptr)
+        spilling = std::make_unique<Spilling>();
+    spilling->threshold = thresholdSize;
+    spilling->directory = directory;
+}
+
+size_t MediaDataQueue::appendToChunk(const uint8_t* src, size_t size)
+{
+    if(tail == nullptr || tail->isAttached() || tail->end == CHUNK_SIZE)
+        pushBack(acquireChunk());
+
+    auto copySize = std::min(size, CHUNK_SIZE - tail->end);
+    std::copy_n(src, copySize, static_cast<Chunk*>(tail)->storage + tail->end);
+    tail->end += copySize;
+    return copySize;
+}
+
+//Returns 0 if data couldn't be spilled - spilling is turned off then, and data is kept in memory
+size_t MediaDataQueue::spill(const uint8_t* src, size_t size)
+{
+    auto& spillFile = spilling->file;
+    if(spillFile == nullptr && (spillFile = SpillFile::open(spilling->directory)) == nullptr)
+    {
+        spilling.reset();
+        return 0;
+    }
+
+    if(tail == nullptr || !tail->isSpilled || tail->end == SpillFile::WINDOW_SIZE)
+    {
+        auto window = spillFile->mapWindow();
+        if(window.data == nullptr)
+        {
+            spilling.reset();
+            return 0;
+        }
+
+        auto segment = acquireSegment();
+        segment->data = window.data;
+        segment->owner = std::move(window.owner);
+        segment->isSpilled = true;
+        segment->spillOffset = window.offset;
+        pushBack(segment);
+    }
+
+    auto copySize = std::min(size, SpillFile::WINDOW_SIZE - tail->end);
+    if(!spillFile->write(tail->spillOffset + tail->end, src, copySize))
+    {
+        spilling.reset();
+        return 0;
+    }
+
+    tail->end += copySize;
+    return copySize;
+}
+
+void MediaDataQueue::pushBack(Segment* segment)
+{
+    (tail == nullptr ? head : tail->next) = segment;
+    tail = segment;
+    if(readSegment == nullptr)
+        rewind();
+}
+
+MediaDataQueue::Chunk* MediaDataQueue::acquireChunk()
+{
+    auto chunk = chunkPool.acquire();
+    chunk->data = chunk->storage;
+    chunk->begin = chunk->end = 0;
+    chunk->isSpilled = false;
+    return chunk;
+}
+
+MediaDataQueue::Segment* MediaDataQueue::acquireSegment()
+{
+    auto segment = segmentPool.acquire();
+    segment->begin = segment->end = 0;
+    segment->isSpilled = false;
+    return segment;
+}
+
+void MediaDataQueue::release(Segment* segment)
+{
+    if(segment->isAttached())
+    {
+        segment->owner.reset();
+        segmentPool.release(segment);
+    }
+    else
+        chunkPool.release(static_cast<Chunk*>(segment));
+}
+}
@@ -1,41 +1,73 @@
 #include <algorithm>
+#include <cstdio>
 #include <stdexcept>
 
 #include "MediaStreamContext.hpp"
 #include "MuxerException.hpp"
+#include "Tracing.hpp"
 #include "utils.hpp"
 
 namespace AVMuxer
 {
 namespace
 {
-class EofException : public ::std::exception {};
+constexpr auto NOT_ENOUGH_DATA_MSG = "MediaStreamContext::initializeFormat() - not enough data buffered to identify input stream";
+
+void copyExtradata(AVCodecParameters* codecpar, const ByteVector& extradata)
+{
+    auto buffer = reinterpret_cast<uint8_t*>(av_mallocz(extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+    if(buffer == nullptr)
+        throw MuxerException("Couldn't allocate codec extradata");
+    
+    std::copy(extradata.begin(), extradata.end(), buffer);
+    av_freep(&codecpar->extradata);
+    codecpar->extradata = buffer;
+    codecpar->extradata_size = extradata.size();
+}
 }
 
 int ioRead(void *opaque, uint8_t *buf, int bufsize)
 {
     auto ctxt = reinterpret_cast<AVMuxer::MediaStreamContext*>(opaque);
-    int sizeAvailable = ctxt->mediaDataBuffer.size() - ctxt->posInBuffer;
-    if(sizeAvailable <= 0)
-        throw EofException();
+    if(auto readSize = ctxt->inputState->mediaDataBuffer.read(buf, bufsize); readSize > 0)
+        return readSize;
+    if(ctxt->isInputFinished)
+        return AVERROR_EOF;
+    
+    //While probing, running out of data ends probing (which is then retried with more data);
+    //afterwards demuxer is asked to try again later, so it keeps its state and doesn't flush anything
+    ctxt->isStarved = true;
+    return (ctxt->isProbing ? AVERROR_EOF : AVERROR(EAGAIN));
+}
+
+int64_t ioSeek(void *opaque, int64_t offset, int whence)
+{
+    auto ctxt = reinterpret_cast<AVMuxer::MediaStreamContext*>(opaque);
+    if((whence & ~AVSEEK_FORCE) != SEEK_SET || offset < 0)
+        return AVERROR(ENOSYS);
     
-    auto readSize = std::min(sizeAvailable, bufsize);
-    std::copy_n(ctxt->mediaDataBuffer.data() + ctxt->posInBuffer, readSize, buf);
-    ctxt->posInBuffer += readSize;
-    return readSize;
+    return (ctxt->inputState->mediaDataBuffer.seek(ctxt->inputState->ioStartPosition + offset) ? offset : AVERROR(EINVAL));
 }
 
+constexpr IoProcedures STREAM_IO_PROCEDURES { ioRead, nullptr, ioSeek };
+
 MediaStreamContext::MediaStreamContext(AVStream* newStream)
     : formatCtxt(nullptr), stream(newStream),
-      ioCtxt(this, ioRead, nullptr), posInBuffer(0), packetsCount(0)
+      ioCtxt(this, STREAM_IO_PROCEDURES), inputState(std::make_unique<InputState>()), packetsCount(0),
+      isProbing(false), isStarved(false), isWaitingForData(false), isInputFinished(false)
 {
-    log("Creating MediaStreamContext instance", LogLevel::DEBUG);
+    log(LogLevel::DEBUG, "Creating MediaStreamContext instance");
 }
 
 MediaStreamContext::~MediaStreamContext()
 {
-    log("Deleting MediaStreamContext instance", LogLevel::DEBUG);
+    log(LogLevel::DEBUG, "Deleting MediaStreamContext instance");
     reset();
+    if(inputState->preframedInput)
+    {
+        for(auto& packet : inputState->preframedInput->packets)
+            av_packet_unref(&packet);
+    }
 }
 
 void MediaStreamContext::fillBuffer(const ByteArray& data) const
@@ -43,30 +75,124 @@ void MediaStreamContext::fillBuffer(const ByteArray& data) const
     if(data.empty())
         return;
     
-    if(auto currentSize = mediaDataBuffer.size(); posInBuffer > 0 && (data.size + currentSize) > mediaDataBuffer.capacity())
-    {
-        std::move(mediaDataBuffer.begin() + posInBuffer, mediaDataBuffer.end(), mediaDataBuffer.begin());
-        mediaDataBuffer.resize(currentSize - posInBuffer);
-        posInBuffer = 0;
-    }
+    AVMUXER_TRACE_SCOPE("fillBuffer");
+    inputState->mediaDataBuffer.append(data);
+}
+
+void MediaStreamContext::attachBuffer(const SharedByteArray& data) const
+{
+    inputState->mediaDataBuffer.attach(data);
+}
+
+void MediaStreamContext::queuePacket(const EncodedPacket& input)
+{
+    if(!inputState->preframedInput)
+        throw MuxerException("Codec parameters have to be set before muxing pre-framed packets");
+    
+    AVPacket packet;
+    if(auto result = av_new_packet(&packet, input.data.size); result < 0)
+        throw MuxerException("Couldn't allocate packet; the error was: " + getAvErrorString(result));
+    
+    std::copy_n(input.data.begin(), input.data.size, packet.data);
+    packet.pts = input.pts;
+    packet.dts = (input.dts != AV_NOPTS_VALUE ? input.dts : input.pts);
+    packet.duration = (input.duration > 0 ? input.duration : inputState->preframedInput->defaultDuration);
+    packet.flags = (input.isKeyframe ? AV_PKT_FLAG_KEY : 0);
+    inputState->preframedInput->packets.push_back(packet);
+    inputState->preframedInput->queuedSize += input.data.size;
+}
+
+void MediaStreamContext::setCodecParameters(const CodecParameters& params)
+{
+    if(*this)
+        throw MuxerException("Codec parameters can't be set for stream that is already initialized");
+    if(!isTimeBaseValid(params.timeBase))
+        throw std::invalid_argument("Time base of pre-framed packets can't be zero");
+    
+    auto codecpar = stream->codecpar;
+    codecpar->codec_type  = params.type;
+    codecpar->codec_id    = params.codecId;
+    codecpar->width       = params.width;
+    codecpar->height      = params.height;
+    codecpar->sample_rate = params.sampleRate;
+    codecpar->channels    = params.channels;
+    codecpar->frame_size  = params.frameSize;
+    if(!params.extradata.empty())
+        copyExtradata(codecpar, params.extradata);
+
+    int64_t defaultDuration = 0;
+    if(params.type == AVMEDIA_TYPE_VIDEO && isTimeBaseValid(stream->r_frame_rate))
+        defaultDuration = av_rescale_q(1, stream->r_frame_rate, params.timeBase);
+    else if(params.type == AVMEDIA_TYPE_AUDIO && params.frameSize > 0 && params.sampleRate > 0)
+        defaultDuration = av_rescale_q(params.frameSize, AVRational{1, params.sampleRate}, params.timeBase);
+    
+    stream->time_base = params.timeBase;
+    inputState->preframedInput.reset(new PreframedInput { {}, params.timeBase, defaultDuration, 0 });
+    log(LogLevel::INFO, "MediaStreamContext::setCodecParameters() - stream set up for pre-framed packets");
+}
+
+void MediaStreamContext::setProbeHints(const StreamProbeHints& hints)
+{
+    if(*this)
+        throw MuxerException("Probe hints can't be set for stream that is already initialized");
+    
+    auto inputFormat = (hints.formatName != nullptr ? av_find_input_format(hints.formatName) : nullptr);
+    if(hints.formatName != nullptr && inputFormat == nullptr)
+        throw std::invalid_argument(std::string("Unknown input format: ") + hints.formatName);
+    
+    inputState->probeSettings.reset(new ProbeSettings { inputFormat, hints.codecId, hints.probeSize, hints.analyzeDuration, hints.extradata });
+}
 
-    mediaDataBuffer.insert(mediaDataBuffer.end(), data.begin(), data.end());
+void MediaStreamContext::finishInput()
+{
+    isInputFinished = true;
+    isWaitingForData = false;
+    //Whatever is buffered is all there is, so it's worth another probing attempt
+    inputState->nextProbeAttemptSize = 0;
 }
 
 AVPacket MediaStreamContext::getNextFrame()
 {
+    if(inputState->preframedInput)
+        return takeQueuedPacket();
+    
     if(!*this && !initializeFormat())
         return {};
     
+    //Demuxer ran out of data last time and nothing new came in since then
+    if(isWaitingForData && inputState->mediaDataBuffer.unreadSize() == 0)
+        return {};
+    
     AVPacket packet = { .data = nullptr, .size = 0 };
     av_init_packet(&packet);
-    try { av_read_frame(formatCtxt, &packet); }
-    catch(const EofException& e)
+    auto startPosition = avio_tell(formatCtxt->pb);
+    formatCtxt->pb->eof_reached = 0;
+    formatCtxt->pb->error = 0;
+    isStarved = false;
+    int result;
+    {
+        AVMUXER_TRACE_SCOPE("av_read_frame");
+        result = av_read_frame(formatCtxt, &packet);
+    }
+    if(result < 0)
     {
+        //Parser has already taken in whatever was read (and keeps it until rest of the frame comes), so replaying it
+        //would duplicate data - input is rewound only for demuxers which read whole packets at once
+        if(isWaitingForData = isStarved; isStarved)
+        {
+            if(av_stream_get_parser(formatCtxt->streams[0]) == nullptr)
+                rewindInput(startPosition);
+        }
+        else if(result != AVERROR_EOF || !isInputFinished)
+            log(LogLevel::WARNING, "MediaStreamContext::getNextFrame() - av_read_frame() failed with error: ", AvErrorCode { result });
+        
         return invalidatePacket(packet);
     }
-    
+
+    isWaitingForData = false;
+    inputState->mediaDataBuffer.discardUntil(inputState->ioStartPosition + avio_tell(formatCtxt->pb));
     packet.stream_index = stream->index;
+    AVMUXER_TRACE_SCOPE("rescaleTimestamps");
     if(packet.pts == AV_NOPTS_VALUE)
     {
         auto inputTimeBase = (isTimeBaseValid(stream->r_frame_rate) ? stream->r_frame_rate : formatCtxt->streams[0]->time_base);
@@ -87,58 +213,117 @@ AVPacket MediaStreamContext::getNextFrame()
 
 bool MediaStreamContext::initializeFormat()
 {
-    auto cleanAndReportFailure = [this](const std::string& errMsg, bool asWarning = false)
+    //Each attempt reads buffered data from the very beginning, so attempts are spaced out to keep overall
+    //probing work linear - next one waits until buffered data doubles, or grows by probe size if it's bounded with hints
+    auto bufferedSize = inputState->mediaDataBuffer.size();
+    if(bufferedSize == 0 || bufferedSize < inputState->nextProbeAttemptSize)
+        return false;
+    
+    AVMUXER_TRACE_SCOPE("probe");
+    ++inputState->probeAttemptsCount;
+    auto cleanAndReportFailure = [this, bufferedSize](LogLevel level, const auto&... errMsgParts)
     {
+        auto step = bufferedSize;
+        if(inputState->probeSettings && inputState->probeSettings->probeSize > 0)
+            step = std::min<size_t>(step, inputState->probeSettings->probeSize);
+        inputState->nextProbeAttemptSize = bufferedSize + step;
         reset();
-        log(errMsg, (asWarning ? LogLevel::WARNING : LogLevel::ERROR));
+        log(level, errMsgParts...);
         return false;
     };
 
-    try
-    {
-        if(formatCtxt = avformat_alloc_context(); formatCtxt == nullptr)
-            return cleanAndReportFailure("MediaStreamContext::initializeFormat() - avformat_alloc_context() failed");
-        
-        ioCtxt->seekable = 0;
-        formatCtxt->pb = ioCtxt;
-        if(auto result = avformat_open_input(&formatCtxt, nullptr, nullptr, nullptr); result < 0)
-            return cleanAndReportFailure("MediaStreamContext::initializeFormat() - avformat_open_input() failed with error: " + getAvErrorString(result));
-        
-        log("MediaStreamContext::initializeFormat() - detected input streams: " + std::to_string(formatCtxt->nb_streams),
-            LogLevel::DEBUG);
-        if(formatCtxt->nb_streams == 0)
-            return cleanAndReportFailure("No input streams detected (available media data may not be sufficient)", true);
-        
-        if(auto result = avformat_find_stream_info(formatCtxt, nullptr) < 0)
-            return cleanAndReportFailure("MediaStreamContext::initializeFormat() - avformat_find_stream_info() failed with error: " + getAvErrorString(result));
-    }
-    catch(const EofException& e)
-    {
-        reset();
-        return cleanAndReportFailure("MediaStreamContext::initializeFormat() - not enough data buffered to identify input stream", true);
-    }
-    catch(...)
-    {
-        reset();
-        return cleanAndReportFailure("MediaStreamContext::initializeFormat() - an unknown error occurred");
-    }
+    if(formatCtxt = avformat_alloc_context(); formatCtxt == nullptr)
+        return cleanAndReportFailure(LogLevel::ERROR, "MediaStreamContext::initializeFormat() - avformat_alloc_context() failed");
+    
+    applyProbeSettings();
+    ioCtxt->seekable = 0;
+    formatCtxt->pb = ioCtxt;
+    isProbing = true;
+    isStarved = false;
+    auto result = avformat_open_input(&formatCtxt, nullptr, nullptr, nullptr);
+    if(isStarved)
+        return cleanAndReportFailure(LogLevel::WARNING, NOT_ENOUGH_DATA_MSG);
+    if(result < 0)
+        return cleanAndReportFailure(LogLevel::ERROR, "MediaStreamContext::initializeFormat() - avformat_open_input() failed with error: ",
+                                     AvErrorCode { result });
+    
+    log(LogLevel::DEBUG, "MediaStreamContext::initializeFormat() - detected input streams: ", formatCtxt->nb_streams);
+    if(formatCtxt->nb_streams == 0)
+        return cleanAndReportFailure(LogLevel::WARNING, "No input streams detected (available media data may not be sufficient)");
+    
+    result = avformat_find_stream_info(formatCtxt, nullptr);
+    if(isStarved)
+        return cleanAndReportFailure(LogLevel::WARNING, NOT_ENOUGH_DATA_MSG);
+    if(result < 0)
+        return cleanAndReportFailure(LogLevel::ERROR, "MediaStreamContext::initializeFormat() - avformat_find_stream_info() failed with error: ",
+                                     AvErrorCode { result });
 
     avcodec_parameters_copy(stream->codecpar, formatCtxt->streams[0]->codecpar);
+    if(stream->codecpar->extradata_size == 0 && inputState->probeSettings && !inputState->probeSettings->extradata.empty())
+        copyExtradata(stream->codecpar, inputState->probeSettings->extradata);
     stream->time_base = (isTimeBaseValid(stream->r_frame_rate)
         ? stream->r_frame_rate
         : formatCtxt->streams[0]->time_base);
     formatCtxt->opaque = nullptr;
-    log("MediaStreamContext::initializeFormat() - successfully identified input stream", LogLevel::INFO);
+    isProbing = false;
+    inputState->mediaDataBuffer.discardUntil(inputState->ioStartPosition + avio_tell(formatCtxt->pb));
+    log(LogLevel::INFO, "MediaStreamContext::initializeFormat() - successfully identified input stream");
     return true;
 }
 
+void MediaStreamContext::applyProbeSettings()
+{
+    if(!inputState->probeSettings)
+        return;
+    
+    formatCtxt->iformat = inputState->probeSettings->inputFormat;
+    if(inputState->probeSettings->probeSize > 0)
+        formatCtxt->probesize = inputState->probeSettings->probeSize;
+    if(inputState->probeSettings->analyzeDuration > 0)
+        formatCtxt->max_analyze_duration = inputState->probeSettings->analyzeDuration;
+    
+    switch(avcodec_get_type(inputState->probeSettings->codecId))
+    {
+        case AVMEDIA_TYPE_VIDEO: formatCtxt->video_codec_id = inputState->probeSettings->codecId; break;
+        case AVMEDIA_TYPE_AUDIO: formatCtxt->audio_codec_id = inputState->probeSettings->codecId; break;
+        default: break;
+    }
+}
+
+AVPacket MediaStreamContext::takeQueuedPacket()
+{
+    auto& packets = inputState->preframedInput->packets;
+    if(packets.empty())
+        return {};
+    
+    auto packet = packets.front();
+    packets.pop_front();
+    inputState->preframedInput->queuedSize -= packet.size;
+    packet.stream_index = stream->index;
+    av_packet_rescale_ts(&packet, inputState->preframedInput->timeBase, stream->time_base);
+    ++packetsCount;
+    return packet;
+}
+
+void MediaStreamContext::rewindInput(int64_t position)
+{
+    if(auto result = avio_seek(formatCtxt->pb, position, SEEK_SET); result < 0)
+        log(LogLevel::ERROR, "MediaStreamContext::rewindInput() - couldn't rewind input after running out of data; the error was: ",
+            AvErrorCode { static_cast<int>(result) });
+    
+    formatCtxt->pb->eof_reached = 0;
+    formatCtxt->pb->error = 0;
+}
+
 void MediaStreamContext::reset()
 {
     if(formatCtxt != nullptr)
         avformat_close_input(&formatCtxt);
 
     ioCtxt.reset();
-    posInBuffer = 0;
+    inputState->mediaDataBuffer.rewind();
+    inputState->ioStartPosition = inputState->mediaDataBuffer.getStartPosition();
+    isProbing = isStarved = isWaitingForData = false;
 }
 
 }
@@ -0,0 +1,194 @@
+#include <algorithm>
+
+#include "MuxerPool.hpp"
+#include "MuxerException.hpp"
+#include "utils.hpp"
+
+namespace AVMuxer
+{
+void PoolSession::schedule()
+{
+    if(pool == nullptr)
+        throw MuxerException("Session can't be scheduled before it's added to pool - create it with MuxerPool::createSession()");
+
+    auto currentState = state.load(std::memory_order_acquire);
+    while(true)
+    {
+        State newState;
+        switch(currentState)
+        {
+            case IDLE:
+                newState = SCHEDULED;
+                break;
+            case RUNNING:
+                //Worker will put it back to the queue once it's done
+                newState = RESCHEDULED;
+                break;
+            default:
+                return;
+        }
+
+        if(state.compare_exchange_weak(currentState, newState, std::memory_order_acq_rel))
+            break;
+    }
+
+    if(currentState == IDLE)
+        pool->enqueue(shared_from_this());
+}
+
+std::exception_ptr PoolSession::getError() const
+{
+    return state.load(std::memory_order_acquire) == FAILED ? error : nullptr;
+}
+
+MuxerPool::MuxerPool(unsigned workersCount)
+{
+    workersCount = std::max(workersCount, 1u);
+    queues.reserve(workersCount);
+    for(unsigned i = 0; i < workersCount; ++i)
+        queues.push_back(std::make_unique<WorkQueue>());
+
+    workers.reserve(workersCount);
+    for(unsigned i = 0; i < workersCount; ++i)
+        workers.emplace_back(&MuxerPool::runWorker, this, i);
+}
+
+MuxerPool::~MuxerPool()
+{
+    isStopping.store(true, std::memory_order_relaxed);
+    //Taking each queue's lock makes sure its worker either sees the flag or is already waiting for notification
+    for(auto& queue : queues)
+    {
+        std::lock_guard lock(queue->mutex);
+        queue->wakeUpCondition.notify_one();
+    }
+
+    for(auto& worker : workers)
+        worker.join();
+}
+
+void MuxerPool::addSession(const PoolSessionSharedPtr& session)
+{
+    session->pool = this;
+    session->homeWorker = nextHomeWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+}
+
+void MuxerPool::enqueue(PoolSessionSharedPtr session)
+{
+    auto homeWorker = session->homeWorker;
+    auto& queue = *queues[homeWorker];
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.sessions.push_back(std::move(session));
+        if(queue.isSleeping)
+        {
+            queue.wakeUpCondition.notify_one();
+            return;
+        }
+    }
+
+    //Worker which is awake between sessions picks it up itself; only busy one's queue is left for idle ones to rob
+    if(queue.isRunningSession.load(std::memory_order_relaxed))
+        wakeUpThief(homeWorker);
+}
+
+void MuxerPool::wakeUpThief(unsigned homeWorker)
+{
+    if(sleepingCount.load(std::memory_order_relaxed) == 0)
+        return;
+
+    for(unsigned i = 1; i < queues.size(); ++i)
+    {
+        auto& queue = *queues[(homeWorker + i) % queues.size()];
+        std::lock_guard lock(queue.mutex);
+        if(queue.isSleeping && !queue.isWakeUpRequested)
+        {
+            queue.isWakeUpRequested = true;
+            queue.wakeUpCondition.notify_one();
+            return;
+        }
+    }
+}
+
+PoolSessionSharedPtr MuxerPool::takeWork(unsigned workerIndex)
+{
+    //Own queue is served oldest first, others are robbed from the back to keep contention on the front low
+    for(unsigned i = 0; i < queues.size(); ++i)
+    {
+        auto& queue = *queues[(workerIndex + i) % queues.size()];
+        std::lock_guard lock(queue.mutex);
+        if(queue.sessions.empty())
+            continue;
+
+        PoolSessionSharedPtr session;
+        if(i == 0)
+        {
+            session = std::move(queue.sessions.front());
+            queue.sessions.pop_front();
+        }
+        else
+        {
+            session = std::move(queue.sessions.back());
+            queue.sessions.pop_back();
+        }
+
+        return session;
+    }
+
+    return nullptr;
+}
+
+void MuxerPool::runSession(const PoolSessionSharedPtr& session)
+{
+    session->state.store(PoolSession::RUNNING, std::memory_order_release);
+    try
+    {
+        session->process();
+    }
+    catch(...)
+    {
+        log(LogLevel::ERROR, "MuxerPool - session failed and won't be processed anymore");
+        session->error = std::current_exception();
+        session->state.store(PoolSession::FAILED, std::memory_order_release);
+        return;
+    }
+
+    auto expectedState = PoolSession::RUNNING;
+    if(session->state.compare_exchange_strong(expectedState, PoolSession::IDLE, std::memory_order_acq_rel))
+        return;
+
+    //Scheduled again while it was processed
+    session->state.store(PoolSession::SCHEDULED, std::memory_order_release);
+    enqueue(session);
+}
+
+void MuxerPool::runWorker(unsigned workerIndex)
+{
+    auto& queue = *queues[workerIndex];
+    while(true)
+    {
+        if(auto session = takeWork(workerIndex))
+        {
+            queue.isRunningSession.store(true, std::memory_order_relaxed);
+            runSession(session);
+            queue.isRunningSession.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        //Work queued before stopping is still done
+        if(isStopping.load(std::memory_order_relaxed))
+            return;
+
+        std::unique_lock lock(queue.mutex);
+        queue.isSleeping = true;
+        sleepingCount.fetch_add(1, std::memory_order_relaxed);
+        queue.wakeUpCondition.wait(lock, [this, &queue]
+        {
+            return isStopping.load(std::memory_order_relaxed) || queue.isWakeUpRequested || !queue.sessions.empty();
+        });
+        sleepingCount.fetch_sub(1, std::memory_order_relaxed);
+        queue.isSleeping = false;
+        queue.isWakeUpRequested = false;
+    }
+}
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#include <unistd.h>
+
+#include "OutputSink.hpp"
+#include "MuxerException.hpp"
+
+extern "C"
+{
+    #include <libavutil/error.h>
+}
+
+namespace AVMuxer
+{
+int ChunkedBufferSink::write(const uint8_t* data, int size)
+{
+    muxedData.append(data, size);
+    return size;
+}
+
+ByteVector ChunkedBufferSink::takeData()
+{
+    ByteVector result(muxedData.size());
+    muxedData.read(result.data(), result.size());
+    return result;
+}
+
+size_t ChunkedBufferSink::read(uint8_t* dst, size_t capacity)
+{
+    return muxedData.read(dst, capacity);
+}
+
+int ByteVectorSink::write(const uint8_t* data, int size)
+{
+    if(readOffset >= muxedData.size() / 2)
+        compact();
+    muxedData.insert(muxedData.end(), data, data + size);
+    return size;
+}
+
+ByteVector ByteVectorSink::takeData()
+{
+    compact();
+    ByteVector result;
+    result.swap(muxedData);
+    return result;
+}
+
+size_t ByteVectorSink::read(uint8_t* dst, size_t capacity)
+{
+    auto readSize = std::min(capacity, getPendingDataSize());
+    std::copy_n(muxedData.begin() + readOffset, readSize, dst);
+    readOffset += readSize;
+    if(readOffset == muxedData.size())
+        compact();
+    return readSize;
+}
+
+void ByteVectorSink::compact()
+{
+    muxedData.erase(muxedData.begin(), muxedData.begin() + readOffset);
+    readOffset = 0;
+}
+
+CallbackSink::CallbackSink(Callback&& outputCallback) : callback(std::move(outputCallback))
+{
+    if(!callback)
+        throw MuxerException("Output callback can't be empty");
+}
+
+int CallbackSink::write(const uint8_t* data, int size)
+{
+    return callback(ByteArray(data, size)) ? size : AVERROR(EIO);
+}
+
+FileDescriptorSink::FileDescriptorSink(int outputFd) : fd(outputFd)
+{
+    if(fd < 0)
+        throw MuxerException("Invalid output file descriptor");
+}
+
+int FileDescriptorSink::write(const uint8_t* data, int size)
+{
+    for(int written = 0; written < size;)
+    {
+        if(auto result = ::write(fd, data + written, size - written); result >= 0)
+            written += result;
+        else if(errno != EINTR)
+            return AVERROR(errno);
+    }
+    return size;
+}
+
+SegmentSink::SegmentSink(Callback&& segmentCallback, ChunkCallback&& chunkCallback)
+    : callback(std::move(segmentCallback)), chunkCallback(std::move(chunkCallback))
+{
+    if(!callback)
+        throw MuxerException("Segment callback can't be empty");
+}
+
+int SegmentSink::write(const uint8_t* data, int size)
+{
+    segmentData.insert(segmentData.end(), data, data + size);
+    return size;
+}
+
+void SegmentSink::closeSegment(const SegmentInfo& info)
+{
+    Segment segment { info, {} };
+    segment.data.swap(segmentData);
+    //Next segment is likely to be of similar size
+    segmentData.reserve(segment.data.size());
+    chunkStartOffset = 0;
+    callback(std::move(segment));
+}
+
+void SegmentSink::closeChunk(const SegmentInfo& info)
+{
+    if(chunkCallback)
+        chunkCallback(info, ByteArray(segmentData.data() + chunkStartOffset, segmentData.size() - chunkStartOffset));
+    chunkStartOffset = segmentData.size();
+}
+}
@@ -0,0 +1,107 @@
+#include <cerrno>
+#include <cstdlib>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "SpillFile.hpp"
+
+namespace AVMuxer
+{
+namespace
+{
+int createUnlinkedFile(const std::string& directory)
+{
+    #ifdef O_TMPFILE
+    if(auto fd = ::open(directory.c_str(), O_TMPFILE | O_RDWR | O_EXCL | O_CLOEXEC, 0600); fd >= 0)
+        return fd;
+    #endif
+
+    //Fallback for filesystems (and systems) without O_TMPFILE support
+    auto path = directory + "/avmuxer-spill-XXXXXX";
+    auto fd = mkstemp(path.data());
+    if(fd >= 0)
+        unlink(path.c_str());
+    return fd;
+}
+}
+
+std::shared_ptr<SpillFile> SpillFile::open(const std::string& directory)
+{
+    auto tmpDir = std::getenv("TMPDIR");
+    auto fd = createUnlinkedFile(!directory.empty() ? directory : (tmpDir != nullptr ? tmpDir : "/tmp"));
+    if(fd < 0)
+    {
+        log(LogLevel::WARNING, "SpillFile::open() - couldn't create spill file, errno: ", errno);
+        return nullptr;
+    }
+
+    return std::shared_ptr<SpillFile>(new SpillFile(fd));
+}
+
+SpillFile::SpillFile(int fileDescriptor) : fd(fileDescriptor), nextWindowOffset(0), mappedWindowsCount(0)
+{}
+
+SpillFile::~SpillFile()
+{
+    close(fd);
+}
+
+SpillFile::Window SpillFile::mapWindow()
+{
+    //Mapping may reach beyond end of file - only its part that's been written is ever read
+    auto mapping = mmap(nullptr, WINDOW_SIZE, PROT_READ, MAP_SHARED, fd, nextWindowOffset);
+    if(mapping == MAP_FAILED)
+    {
+        log(LogLevel::WARNING, "SpillFile::mapWindow() - mmap() failed, errno: ", errno);
+        return Window { nullptr, 0, nullptr };
+    }
+
+    madvise(mapping, WINDOW_SIZE, MADV_SEQUENTIAL);
+    auto offset = std::exchange(nextWindowOffset, nextWindowOffset + WINDOW_SIZE);
+    ++mappedWindowsCount;
+    std::shared_ptr<const void> owner(mapping, [file = shared_from_this(), offset](const void* m)
+    {
+        file->releaseWindow(const_cast<void*>(m), offset);
+    });
+    return Window { static_cast<const uint8_t*>(mapping), offset, std::move(owner) };
+}
+
+bool SpillFile::write(uint64_t offset, const uint8_t* data, size_t size)
+{
+    while(size > 0)
+    {
+        auto result = pwrite(fd, data, size, offset);
+        if(result < 0 && errno == EINTR)
+            continue;
+        if(result <= 0)
+        {
+            log(LogLevel::WARNING, "SpillFile::write() - pwrite() failed, errno: ", errno);
+            return false;
+        }
+
+        data += result;
+        offset += result;
+        size -= result;
+    }
+    return true;
+}
+
+void SpillFile::releaseWindow(void* mapping, uint64_t offset)
+{
+    munmap(mapping, WINDOW_SIZE);
+    if(--mappedWindowsCount == 0)
+    {
+        //Nothing is spilled anymore - file starts over
+        nextWindowOffset = 0;
+        if(ftruncate(fd, 0) == 0)
+            return;
+    }
+
+    #ifdef FALLOC_FL_PUNCH_HOLE
+    fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, WINDOW_SIZE);
+    #endif
+}
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Tracing.hpp"
+
+namespace AVMuxer::Tracing
+{
+namespace
+{
+struct Span
+{
+    const char* name;
+    uint64_t    startTime;
+    uint64_t    duration;
+};
+
+//Relaxed atomics compile to plain stores, but make reading entry that's being overwritten well-defined
+struct SpanEntry
+{
+    std::atomic<const char*> name;
+    std::atomic<uint64_t>    startTime;
+    std::atomic<uint64_t>    duration;
+
+    void store(const char* spanName, uint64_t start, uint64_t spanDuration)
+    {
+        name.store(spanName, std::memory_order_relaxed);
+        startTime.store(start, std::memory_order_relaxed);
+        duration.store(spanDuration, std::memory_order_relaxed);
+    }
+
+    Span load() const
+    {
+        return Span { name.load(std::memory_order_relaxed), startTime.load(std::memory_order_relaxed),
+                      duration.load(std::memory_order_relaxed) };
+    }
+};
+
+//Written only by its own thread; spans count tells dumping thread which entries are complete
+struct ThreadBuffer
+{
+    uint32_t                                threadId;
+    std::atomic<uint64_t>                   spansCount = 0;
+    std::atomic<uint64_t>                   firstValidSpan = 0;
+    std::array<SpanEntry, RING_BUFFER_SIZE> spans;
+
+    explicit ThreadBuffer(uint32_t id) : threadId(id)
+    {}
+};
+
+//Buffers outlive their threads, so spans of finished threads can still be dumped
+std::mutex                                 registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+
+ThreadBuffer& getThreadBuffer()
+{
+    thread_local ThreadBuffer* buffer = []
+    {
+        std::lock_guard lock(registryMutex);
+        return threadBuffers.emplace_back(std::make_unique<ThreadBuffer>(threadBuffers.size() + 1)).get();
+    }();
+    return *buffer;
+}
+
+void writeSpan(std::ostream& output, const Span& span, uint32_t threadId, bool isFirst)
+{
+    //Chrome trace timestamps are in microseconds
+    output << (isFirst ? "" : ",\n") << R"({"name":")" << span.name << R"(","ph":"X","pid":1,"tid":)" << threadId
+           << R"(,"ts":)" << span.startTime / 1000 << '.' << (span.startTime % 1000) / 100
+           << R"(,"dur":)" << span.duration / 1000 << '.' << (span.duration % 1000) / 100 << '}';
+}
+}
+
+void recordSpan(const char* name, uint64_t startTimeNs, uint64_t durationNs)
+{
+    auto& buffer = getThreadBuffer();
+    auto count = buffer.spansCount.load(std::memory_order_relaxed);
+    buffer.spans[count % RING_BUFFER_SIZE].store(name, startTimeNs, durationNs);
+    buffer.spansCount.store(count + 1, std::memory_order_release);
+}
+
+void writeChromeTrace(std::ostream& output)
+{
+    std::lock_guard lock(registryMutex);
+    bool isFirst = true;
+    output << R"({"displayTimeUnit":"ns","traceEvents":[)" << '\n';
+    for(const auto& buffer : threadBuffers)
+    {
+        auto count = buffer->spansCount.load(std::memory_order_acquire);
+        //Oldest slot is the one owning thread overwrites next, so it's never dumped
+        auto first = std::max(buffer->firstValidSpan.load(std::memory_order_relaxed),
+                              count >= RING_BUFFER_SIZE ? count - RING_BUFFER_SIZE + 1 : 0);
+        std::vector<Span> spans;
+        spans.reserve(count - first);
+        for(auto i = first; i < count; ++i)
+            spans.push_back(buffer->spans[i % RING_BUFFER_SIZE].load());
+
+        //Entries overwritten by owning thread in the meantime (or being overwritten right now) are skipped
+        auto countAfterCopy = buffer->spansCount.load(std::memory_order_acquire);
+        auto firstIntactSpan = countAfterCopy >= RING_BUFFER_SIZE ? countAfterCopy - RING_BUFFER_SIZE + 1 : 0;
+        auto skippedCount = std::min<uint64_t>(firstIntactSpan > first ? firstIntactSpan - first : 0, spans.size());
+        for(size_t i = skippedCount; i < spans.size(); ++i)
+        {
+            writeSpan(output, spans[i], buffer->threadId, isFirst);
+            isFirst = false;
+        }
+    }
+    output << "\n]}\n";
+}
+
+void clear()
+{
+    std::lock_guard lock(registryMutex);
+    for(auto& buffer : threadBuffers)
+        buffer->firstValidSpan.store(buffer->spansCount.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+}
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <utility>
 
 #include "utils.hpp"
@@ -5,9 +6,12 @@
 extern "C"
 {
     #include <libavformat/avformat.h>
+    #include <libavutil/buffer.h>
     #include <libavutil/error.h>
 }
 
+#include "MuxerException.hpp"
+
 namespace AVMuxer
 {
 namespace
@@ -20,24 +24,57 @@ constexpr bool IS_DEBUG_MODE =
                                 false;
                                 #endif
 
-std::unique_ptr<ILogger> logger;
+//Global logger is accessed with std::atomic_load()/atomic_store(), so it can be replaced while other threads log;
+//the flag lets level check skip that when no logger is set
+std::shared_ptr<ILogger> globalLogger;
+std::atomic<bool>        isGlobalLoggerSet = false;
+std::atomic<int>         minLogLevel = LogLevel::DEBUG;
+thread_local ILogger*    scopedLogger = nullptr;
 }
 
-void log(const std::string& msg, LogLevel level)
+void setLogLevel(LogLevel level)
+{
+    minLogLevel.store(level, std::memory_order_relaxed);
+}
+
+bool isLogLevelEnabled(LogLevel level)
 {
     if(level == LogLevel::DEBUG)
     {
         if constexpr(!IS_DEBUG_MODE)
-            return;
+            return false;
     }
 
-    if(logger)
+    return level >= minLogLevel.load(std::memory_order_relaxed)
+        && (scopedLogger != nullptr || isGlobalLoggerSet.load(std::memory_order_relaxed));
+}
+
+void log(const std::string& msg, LogLevel level)
+{
+    if(!isLogLevelEnabled(level))
+        return;
+
+    if(scopedLogger != nullptr)
+        scopedLogger->logAVMuxerMessage(msg, level);
+    else if(auto logger = std::atomic_load(&globalLogger))
         logger->logAVMuxerMessage(msg, level);
 }
 
-void setLogger(std::unique_ptr<ILogger>&& newLogger)
+void setLogger(std::shared_ptr<ILogger> newLogger)
 {
-    logger = std::move(newLogger);
+    isGlobalLoggerSet.store(newLogger != nullptr, std::memory_order_relaxed);
+    std::atomic_store(&globalLogger, std::move(newLogger));
+}
+
+LoggerScope::LoggerScope(ILogger* logger) : previousLogger(scopedLogger)
+{
+    if(logger != nullptr)
+        scopedLogger = logger;
+}
+
+LoggerScope::~LoggerScope()
+{
+    scopedLogger = previousLogger;
 }
 
 std::string getAvErrorString(int errNr)
@@ -46,4 +83,14 @@ std::string getAvErrorString(int errNr)
     av_strerror(errNr, errMsg, AV_ERR_MSG_SIZE);
     return std::string(errMsg);
 }
+
+SharedByteArray makeSharedByteArray(const AVBufferRef* buffer)
+{
+    auto ref = av_buffer_ref(buffer);
+    if(ref == nullptr)
+        throw MuxerException("Couldn't reference shared input buffer - av_buffer_ref() failed");
+
+    std::shared_ptr<const void> owner(ref, [](AVBufferRef* r) { av_buffer_unref(&r); });
+    return SharedByteArray(ref->data, ref->size, std::move(owner));
+}
 }
@@ -4,9 +4,8 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <iterator>
-#include <vector>
 
+#include "MappedFile.hpp"
 #include "Mp4Muxer.hpp"
 #include "utils.hpp"
 
@@ -27,12 +26,7 @@ try
     }
 
     int fps = std::atoi(argv[3]);
-    std::fstream inputFile(argv[1], std::ios::in | std::ios::binary);
-    if(!inputFile.is_open())
-    {
-        std::cout << "Could not open input file " << argv[1] << std::endl;
-        return 1;
-    }
+    auto inputFile = AVMuxer::MappedFile::open(argv[1]);
 
     std::fstream outputFile(argv[2], std::ios::out | std::ios::binary | std::ios::trunc);
     if(!outputFile.is_open())
@@ -44,21 +38,12 @@ try
     av_log_set_level(AV_LOG_TRACE);
     AVMuxer::setLogger(std::make_unique<TestLogger>());
     AVMuxer::VideoOnlyMp4Muxer muxer({1, fps});
-    std::istreambuf_iterator it(inputFile);
-    decltype(it) end;
-    std::vector<uint8_t> readBuffer(it, end);
-    if(muxer.muxVideoData(readBuffer))
+    if(muxer.muxVideoData(inputFile->getData()))
     {
         auto muxedData = muxer.getMuxedData();
         outputFile.write(reinterpret_cast<char*>(muxedData.data()), muxedData.size());
     }
 
-    if(!inputFile && !inputFile.eof())
-    {
-        std::cout << "Error reading input file" << std::endl;
-        return 2;
-    }
-
     if(!outputFile)
     {
         std::cout << "Error reading output file" << std::endl;
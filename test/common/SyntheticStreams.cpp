@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+
+#include "SyntheticStreams.hpp"
+
+namespace AVMuxer::Synthetic
+{
+namespace
+{
+constexpr std::array<uint8_t, 4> START_CODE = {0, 0, 0, 1};
+constexpr int LOG2_MAX_FRAME_NUM = 4;
+constexpr std::array<int, 13> ADTS_SAMPLE_RATES = {96000, 88200, 64000, 48000, 44100, 32000, 24000,
+                                                   22050, 16000, 12000, 11025, 8000, 7350};
+constexpr size_t ADTS_HEADER_SIZE = 7;
+constexpr size_t ADTS_MAX_FRAME_SIZE = 0x1FFF;
+
+enum NalUnitType : uint8_t { NON_IDR_SLICE = 1, IDR_SLICE = 5, SPS = 7, PPS = 8 };
+
+//RBSP writer; emulation prevention is not needed, as written headers are short and payload never contains zeros
+class BitWriter
+{
+    public:
+        void putBits(uint32_t value, int bitsCount)
+        {
+            for(int i = bitsCount - 1; i >= 0; --i)
+                putBit((value >> i) & 1);
+        }
+
+        void putUnsignedExpGolomb(uint32_t value)
+        {
+            int length = 0;
+            for(auto codeNum = value + 1; codeNum > 1; codeNum >>= 1)
+                ++length;
+
+            putBits(0, length);
+            putBits(value + 1, length + 1);
+        }
+
+        void putSignedExpGolomb(int32_t value)
+        {
+            putUnsignedExpGolomb(value > 0 ? 2 * value - 1 : -2 * value);
+        }
+
+        //Stop bit and alignment
+        ByteVector finish()
+        {
+            putBit(1);
+            while(bitsInByte != 0)
+                putBit(0);
+            return std::move(bytes);
+        }
+
+    private:
+        ByteVector bytes;
+        uint8_t    currentByte = 0;
+        int        bitsInByte = 0;
+
+        void putBit(uint32_t bit)
+        {
+            currentByte = (currentByte << 1) | bit;
+            if(++bitsInByte == 8)
+            {
+                bytes.push_back(currentByte);
+                currentByte = 0;
+                bitsInByte = 0;
+            }
+        }
+};
+
+void appendNalUnit(ByteVector& output, uint8_t refIdc, NalUnitType type, const ByteVector& rbsp)
+{
+    output.insert(output.end(), START_CODE.begin(), START_CODE.end());
+    output.push_back((refIdc << 5) | type);
+    output.insert(output.end(), rbsp.begin(), rbsp.end());
+}
+
+ByteVector makeSps(const SyntheticVideoSettings& settings)
+{
+    BitWriter writer;
+    writer.putBits(66, 8);      //profile_idc - baseline
+    writer.putBits(0xC0, 8);    //constraint_set0/1 flags
+    writer.putBits(40, 8);      //level_idc - 4.0
+    writer.putUnsignedExpGolomb(0);                         //seq_parameter_set_id
+    writer.putUnsignedExpGolomb(LOG2_MAX_FRAME_NUM - 4);
+    writer.putUnsignedExpGolomb(2);                         //pic_order_cnt_type - derived from frame_num
+    writer.putUnsignedExpGolomb(1);                         //max_num_ref_frames
+    writer.putBits(0, 1);                                   //gaps_in_frame_num_value_allowed_flag
+    writer.putUnsignedExpGolomb((settings.width + 15) / 16 - 1);
+    writer.putUnsignedExpGolomb((settings.height + 15) / 16 - 1);
+    writer.putBits(1, 1);                                   //frame_mbs_only_flag
+    writer.putBits(1, 1);                                   //direct_8x8_inference_flag
+    writer.putBits(0, 1);                                   //frame_cropping_flag
+    writer.putBits(0, 1);                                   //vui_parameters_present_flag
+    return writer.finish();
+}
+
+ByteVector makePps()
+{
+    BitWriter writer;
+    writer.putUnsignedExpGolomb(0);     //pic_parameter_set_id
+    writer.putUnsignedExpGolomb(0);     //seq_parameter_set_id
+    writer.putBits(0, 1);               //entropy_coding_mode_flag - CAVLC
+    writer.putBits(0, 1);               //bottom_field_pic_order_in_frame_present_flag
+    writer.putUnsignedExpGolomb(0);     //num_slice_groups_minus1
+    writer.putUnsignedExpGolomb(0);     //num_ref_idx_l0_default_active_minus1
+    writer.putUnsignedExpGolomb(0);     //num_ref_idx_l1_default_active_minus1
+    writer.putBits(0, 1);               //weighted_pred_flag
+    writer.putBits(0, 2);               //weighted_bipred_idc
+    writer.putSignedExpGolomb(0);       //pic_init_qp_minus26
+    writer.putSignedExpGolomb(0);       //pic_init_qs_minus26
+    writer.putSignedExpGolomb(0);       //chroma_qp_index_offset
+    writer.putBits(1, 1);               //deblocking_filter_control_present_flag
+    writer.putBits(0, 1);               //constrained_intra_pred_flag
+    writer.putBits(0, 1);               //redundant_pic_cnt_present_flag
+    return writer.finish();
+}
+
+ByteVector makeSliceHeader(bool isIdr, unsigned frameNum)
+{
+    BitWriter writer;
+    writer.putUnsignedExpGolomb(0);                 //first_mb_in_slice
+    writer.putUnsignedExpGolomb(isIdr ? 7 : 5);     //slice_type - I or P, same for whole picture
+    writer.putUnsignedExpGolomb(0);                 //pic_parameter_set_id
+    writer.putBits(frameNum % (1 << LOG2_MAX_FRAME_NUM), LOG2_MAX_FRAME_NUM);
+    if(isIdr)
+        writer.putUnsignedExpGolomb(0);             //idr_pic_id
+    else
+        writer.putBits(0, 2);                       //num_ref_idx_active_override_flag, ref_pic_list_modification_flag_l0
+
+    writer.putBits(0, isIdr ? 2 : 1);               //dec_ref_pic_marking() - all flags off
+    writer.putSignedExpGolomb(0);                   //slice_qp_delta
+    writer.putUnsignedExpGolomb(1);                 //disable_deblocking_filter_idc
+    return writer.finish();
+}
+
+//Payload bytes are never zero, so no start code can be emulated
+void appendPayload(ByteVector& output, size_t size, std::mt19937& generator)
+{
+    std::uniform_int_distribution<int> distribution(1, 0xFE);
+    std::generate_n(std::back_inserter(output), size, [&] { return static_cast<uint8_t>(distribution(generator)); });
+}
+}
+
+std::vector<ByteVector> generateH264AccessUnits(unsigned framesCount, const SyntheticVideoSettings& settings)
+{
+    if(settings.width <= 0 || settings.height <= 0 || settings.gopSize == 0)
+        throw std::invalid_argument("Invalid synthetic video settings");
+
+    std::mt19937 generator(settings.seed);
+    auto sps = makeSps(settings);
+    auto pps = makePps();
+    std::vector<ByteVector> accessUnits(framesCount);
+    for(unsigned i = 0; i < framesCount; ++i)
+    {
+        auto& accessUnit = accessUnits[i];
+        auto frameNumInGop = i % settings.gopSize;
+        bool isIdr = frameNumInGop == 0;
+        if(isIdr)
+        {
+            appendNalUnit(accessUnit, 3, SPS, sps);
+            appendNalUnit(accessUnit, 3, PPS, pps);
+        }
+
+        appendNalUnit(accessUnit, isIdr ? 3 : 2, isIdr ? IDR_SLICE : NON_IDR_SLICE, makeSliceHeader(isIdr, frameNumInGop));
+        appendPayload(accessUnit, isIdr ? settings.keyframeSize : settings.frameSize, generator);
+    }
+
+    return accessUnits;
+}
+
+ByteVector generateH264Stream(unsigned framesCount, const SyntheticVideoSettings& settings)
+{
+    return concatenate(generateH264AccessUnits(framesCount, settings));
+}
+
+std::vector<ByteVector> generateAdtsFrames(unsigned framesCount, const SyntheticAudioSettings& settings)
+{
+    auto sampleRate = std::find(ADTS_SAMPLE_RATES.begin(), ADTS_SAMPLE_RATES.end(), settings.sampleRate);
+    if(sampleRate == ADTS_SAMPLE_RATES.end() || settings.channels < 1 || settings.channels > 7
+       || settings.frameSize + ADTS_HEADER_SIZE > ADTS_MAX_FRAME_SIZE)
+        throw std::invalid_argument("Invalid synthetic audio settings");
+
+    uint32_t sampleRateIndex = sampleRate - ADTS_SAMPLE_RATES.begin();
+    uint32_t frameLength = settings.frameSize + ADTS_HEADER_SIZE;
+    const ByteVector header = {
+        0xFF,
+        0xF1,   //MPEG-4, no CRC
+        static_cast<uint8_t>((1 << 6) | (sampleRateIndex << 2) | (settings.channels >> 2)),    //AAC-LC
+        static_cast<uint8_t>(((settings.channels & 3) << 6) | (frameLength >> 11)),
+        static_cast<uint8_t>(frameLength >> 3),
+        static_cast<uint8_t>(((frameLength & 7) << 5) | 0x1F),  //buffer fullness 0x7FF - VBR
+        0xFC    //one raw data block
+    };
+
+    std::mt19937 generator(settings.seed);
+    std::vector<ByteVector> frames(framesCount, header);
+    for(auto& frame : frames)
+        appendPayload(frame, settings.frameSize, generator);
+
+    return frames;
+}
+
+ByteVector generateAdtsStream(unsigned framesCount, const SyntheticAudioSettings& settings)
+{
+    return concatenate(generateAdtsFrames(framesCount, settings));
+}
+
+ByteVector concatenate(const std::vector<ByteVector>& parts)
+{
+    size_t totalSize = 0;
+    for(const auto& part : parts)
+        totalSize += part.size();
+
+    ByteVector result;
+    result.reserve(totalSize);
+    for(const auto& part : parts)
+        result.insert(result.end(), part.begin(), part.end());
+    return result;
+}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DataStructures.hpp"
+
+namespace AVMuxer::Synthetic
+{
+//Elementary streams with valid headers (enough for probing, parsing and muxing) and pseudo-random payload,
+//so tests and benchmarks are reproducible without any media assets. They're not meant to be decodable
+struct SyntheticVideoSettings
+{
+    int      width = 1280;
+    int      height = 720;
+    unsigned gopSize = 30;
+    size_t   keyframeSize = 60000;
+    size_t   frameSize = 12000;
+    uint32_t seed = 1;
+};
+
+struct SyntheticAudioSettings
+{
+    int      sampleRate = 48000;
+    int      channels = 2;
+    size_t   frameSize = 384;
+    uint32_t seed = 2;
+};
+
+//AAC frame always carries 1024 samples
+constexpr int AAC_SAMPLES_PER_FRAME = 1024;
+
+//H.264 Annex-B access units - first one (and every gopSize-th) is IDR preceded with SPS and PPS
+std::vector<ByteVector> generateH264AccessUnits(unsigned framesCount, const SyntheticVideoSettings& settings = {});
+ByteVector              generateH264Stream(unsigned framesCount, const SyntheticVideoSettings& settings = {});
+
+//AAC-LC frames with ADTS headers
+std::vector<ByteVector> generateAdtsFrames(unsigned framesCount, const SyntheticAudioSettings& settings = {});
+ByteVector              generateAdtsStream(unsigned framesCount, const SyntheticAudioSettings& settings = {});
+
+ByteVector concatenate(const std::vector<ByteVector>& parts);
+}
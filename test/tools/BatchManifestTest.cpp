@@ -0,0 +1,70 @@
+#include <sstream>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include "BatchManifest.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+using namespace AVMuxer::Tools;
+
+TEST(BatchManifestTest, FramerateShouldBeParsedAsWholeNumberOrFraction)
+{
+    AVRational framerate;
+    ASSERT_TRUE(parseFramerate("25", framerate));
+    EXPECT_EQ(framerate.num, 25);
+    EXPECT_EQ(framerate.den, 1);
+
+    ASSERT_TRUE(parseFramerate("30000/1001", framerate));
+    EXPECT_EQ(framerate.num, 30000);
+    EXPECT_EQ(framerate.den, 1001);
+}
+
+TEST(BatchManifestTest, InvalidFramerateShouldBeRejected)
+{
+    AVRational framerate;
+    for(auto text : { "", "0", "-1", "30/", "30/0", "1/-1", "abc", "25x", "25/1x", "99999999999" })
+        EXPECT_FALSE(parseFramerate(text, framerate)) << "Framerate: \"" << text << "\"";
+}
+
+TEST(BatchManifestTest, JobsShouldBeReadSkippingCommentsAndEmptyLines)
+{
+    std::istringstream manifest("# video audio fps output\n"
+                                "\n"
+                                "a.h264 a.aac 25 a.mp4\n"
+                                "   \n"
+                                "b.h264  -  30000/1001  b.mp4\n");
+    auto jobs = readManifest(manifest);
+    ASSERT_EQ(jobs.size(), 2);
+
+    EXPECT_EQ(jobs[0].videoPath, "a.h264");
+    EXPECT_EQ(jobs[0].audioPath, "a.aac");
+    EXPECT_EQ(jobs[0].framerate.num, 25);
+    EXPECT_EQ(jobs[0].framerate.den, 1);
+    EXPECT_EQ(jobs[0].outputPath, "a.mp4");
+
+    EXPECT_EQ(jobs[1].videoPath, "b.h264");
+    EXPECT_TRUE(jobs[1].audioPath.empty());
+    EXPECT_EQ(jobs[1].framerate.num, 30000);
+    EXPECT_EQ(jobs[1].framerate.den, 1001);
+    EXPECT_EQ(jobs[1].outputPath, "b.mp4");
+}
+
+TEST(BatchManifestTest, InvalidJobShouldBeReportedWithItsLine)
+{
+    for(auto text : { "a.h264 a.aac 25\n", "a.h264 a.aac 25 a.mp4 extra\n", "a.h264 - 0 a.mp4\n" })
+    {
+        std::istringstream manifest(std::string("# header\n") + text);
+        try
+        {
+            readManifest(manifest);
+            ADD_FAILURE() << "Manifest wasn't rejected: " << text;
+        }
+        catch(const std::invalid_argument& e)
+        {
+            EXPECT_NE(std::string(e.what()).find("line 2"), std::string::npos) << e.what();
+        }
+    }
+}
+}
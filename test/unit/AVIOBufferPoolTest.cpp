@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include "AVIOContextWrapper.hpp"
+#include "utils.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+int dummyWrite(void*, uint8_t*, int size)
+{
+    return size;
+}
+
+constexpr IoProcedures OUTPUT_PROCEDURES { nullptr, dummyWrite, nullptr };
+}
+
+TEST(AVIOBufferPoolTest, ReleasedBufferShouldBeReused)
+{
+    auto& pool = AVIOBufferPool::getInstance();
+    auto buffer = pool.acquire(3 * PAGE_SIZE);
+    auto pooledSize = pool.getPooledSize();
+
+    pool.release(buffer, 3 * PAGE_SIZE);
+    EXPECT_EQ(pool.getPooledSize(), pooledSize + 3 * PAGE_SIZE);
+    EXPECT_EQ(pool.acquire(3 * PAGE_SIZE), buffer);
+    EXPECT_EQ(pool.getPooledSize(), pooledSize);
+    pool.release(buffer, 3 * PAGE_SIZE);
+}
+
+TEST(AVIOBufferPoolTest, ContextShouldBeCreatedOnFirstUseAndItsBufferPooledOnReset)
+{
+    AVIOContextWrapper ioCtxt(nullptr, OUTPUT_PROCEDURES);
+    ioCtxt.setBufferSize(5 * PAGE_SIZE - 100);
+    EXPECT_FALSE(ioCtxt.isInitialized());
+
+    auto buffer = ioCtxt->buffer;
+    EXPECT_TRUE(ioCtxt.isInitialized());
+    EXPECT_EQ(ioCtxt->buffer_size, 5 * PAGE_SIZE);
+
+    auto pooledSize = AVIOBufferPool::getInstance().getPooledSize();
+    ioCtxt.reset();
+    EXPECT_FALSE(ioCtxt.isInitialized());
+    EXPECT_EQ(AVIOBufferPool::getInstance().getPooledSize(), pooledSize + 5 * PAGE_SIZE);
+    EXPECT_EQ(ioCtxt->buffer, buffer);
+}
+
+TEST(AVIOBufferPoolTest, DefaultSizeShouldApplyPerRole)
+{
+    auto defaultSize = getDefaultIoBufferSize(IoBufferRole::OUTPUT);
+    setDefaultIoBufferSize(IoBufferRole::OUTPUT, 16 * PAGE_SIZE);
+    {
+        AVIOContextWrapper ioCtxt(nullptr, OUTPUT_PROCEDURES);
+        EXPECT_EQ(ioCtxt->buffer_size, 16 * PAGE_SIZE);
+        EXPECT_EQ(getDefaultIoBufferSize(IoBufferRole::INPUT), PAGE_SIZE);
+    }
+
+    setDefaultIoBufferSize(IoBufferRole::OUTPUT, defaultSize);
+    EXPECT_THROW(setDefaultIoBufferSize(IoBufferRole::INPUT, 0), std::invalid_argument);
+}
+}
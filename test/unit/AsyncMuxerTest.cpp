@@ -0,0 +1,298 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+#include "AsyncMuxer.hpp"
+#include "MediaStreamMock.hpp"
+#include "MediaContainerMock.hpp"
+#include "MuxerException.hpp"
+#include "utils.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr auto FPS                  = 24;
+constexpr auto BUFFERS_COUNT        = 16;
+constexpr auto FLUSHES_COUNT        = 4;
+constexpr auto MAX_INTERLEAVE_DELTA = 2 * AV_TIME_BASE;
+constexpr auto FLUSH_TIMEOUT        = std::chrono::seconds(5);
+
+class LoggerMock : public ILogger
+{
+    public:
+        MOCK_METHOD(void, logAVMuxerMessage, (const std::string& msg, LogLevel level), (override));
+};
+}
+
+class AsyncMuxerTest : public AsyncMuxer<1>
+{
+    public:
+        //Mocks are swapped in before any input is pushed, so worker thread doesn't touch real contexts
+        AsyncMuxerTest(std::shared_ptr<MediaContainerWrapper> containerCtxtMock, WrappedMediaStreamSharedPtr streamCtxtMock,
+                       OutputSinkSharedPtr outputSink = std::make_shared<CallbackSink>([](const ByteArray&) { return true; }))
+            : AsyncMuxer<1>("mp4", AVRational {FPS, 1}, outputSink)
+        {
+            containerCtxt = containerCtxtMock;
+            streams[0] = streamCtxtMock;
+        }
+};
+
+class AsyncMuxerTestFixture : public Test
+{
+    public:
+        AsyncMuxerTestFixture()
+            : containerCtxtMock(std::make_shared<StrictMock<MediaContainerMock>>("mp4")),
+              streamCtxtMock(std::make_shared<StrictMock<MediaStreamMock>>())
+        {
+            EXPECT_CALL(*streamCtxtMock, boolOp()).WillRepeatedly(Return(true));
+            EXPECT_CALL(*streamCtxtMock, attachBuffer(_)).Times(AnyNumber());
+            EXPECT_CALL(*streamCtxtMock, fillBuffer(_)).Times(AnyNumber());
+            EXPECT_CALL(*streamCtxtMock, getTimeBase()).WillRepeatedly(Return(AVRational {1, FPS}));
+            EXPECT_CALL(*containerCtxtMock, boolOp()).WillRepeatedly(Return(true));
+            EXPECT_CALL(*containerCtxtMock, getMaxInterleaveDelta()).WillRepeatedly(Return(MAX_INTERLEAVE_DELTA));
+        }
+
+    protected:
+        //Every pushed buffer holds exactly one frame
+        void expectFramePerBuffer()
+        {
+            EXPECT_CALL(*streamCtxtMock, attachBuffer(_)).WillRepeatedly([this](const SharedByteArray&) { ++pendingFrames; });
+            EXPECT_CALL(*streamCtxtMock, getNextFrame()).WillRepeatedly([this]
+            {
+                return pendingFrames.exchange(0) > 0 ? AVPacket {.size = 1, .duration = 1} : AVPacket {.size = 0};
+            });
+        }
+
+        std::shared_ptr<StrictMock<MediaContainerMock>> containerCtxtMock;
+        std::shared_ptr<StrictMock<MediaStreamMock>>    streamCtxtMock;
+        std::atomic<int>                                pendingFrames = 0;
+        const ByteVector                                inputData = {0, 1, 2, 3};
+};
+
+TEST(AsyncMuxerTest, MuxerShouldNotBeCreatedWithoutSink)
+{
+    ASSERT_THROW(AsyncMuxer<1>("mp4", AVRational {FPS, 1}, nullptr), std::invalid_argument);
+}
+
+TEST_F(AsyncMuxerTestFixture, PushedDataShouldBeMuxedOnWorkerThreadBeforeFlushIsDone)
+{
+    std::atomic<int> packetsCount = 0;
+    std::atomic<bool> isMuxedOnCallerThread = false;
+    auto callerThread = std::this_thread::get_id();
+    expectFramePerBuffer();
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillRepeatedly([&](AVPacket&&)
+    {
+        isMuxedOnCallerThread = isMuxedOnCallerThread || std::this_thread::get_id() == callerThread;
+        ++packetsCount;
+        return false;
+    });
+
+    AsyncMuxerTest muxer(containerCtxtMock, streamCtxtMock);
+    for(int i = 0; i < BUFFERS_COUNT; ++i)
+        ASSERT_TRUE(muxer.pushMediaData<0>(inputData));
+
+    auto flushed = muxer.flush();
+    ASSERT_EQ(flushed.wait_for(FLUSH_TIMEOUT), std::future_status::ready);
+    flushed.get();
+    ASSERT_EQ(packetsCount, BUFFERS_COUNT);
+    ASSERT_FALSE(isMuxedOnCallerThread);
+    ASSERT_EQ(muxer.getMetrics().packetsMuxed, BUFFERS_COUNT);
+    ASSERT_EQ(muxer.getError(), nullptr);
+}
+
+TEST_F(AsyncMuxerTestFixture, EveryFlushRequestShouldBeCompleted)
+{
+    EXPECT_CALL(*streamCtxtMock, getNextFrame()).WillRepeatedly(Return(AVPacket {.size = 0}));
+    AsyncMuxerTest muxer(containerCtxtMock, streamCtxtMock);
+
+    std::vector<std::future<void>> flushes;
+    for(int i = 0; i < FLUSHES_COUNT; ++i)
+        flushes.push_back(muxer.flush());
+
+    for(auto& flushed : flushes)
+    {
+        ASSERT_EQ(flushed.wait_for(FLUSH_TIMEOUT), std::future_status::ready);
+        ASSERT_NO_THROW(flushed.get());
+    }
+}
+
+TEST_F(AsyncMuxerTestFixture, InputShouldBeFinishedOnWorkerThreadAfterDataPushedBefore)
+{
+    std::atomic<int> packetsCount = 0;
+    std::atomic<int> packetsCountWhenFinished = -1;
+    std::atomic<bool> isFinishedOnCallerThread = false;
+    auto callerThread = std::this_thread::get_id();
+    expectFramePerBuffer();
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillRepeatedly([&packetsCount](AVPacket&&)
+    {
+        ++packetsCount;
+        return false;
+    });
+    EXPECT_CALL(*streamCtxtMock, finishInput()).WillOnce([&]
+    {
+        isFinishedOnCallerThread = std::this_thread::get_id() == callerThread;
+        packetsCountWhenFinished = packetsCount.load();
+    });
+
+    AsyncMuxerTest muxer(containerCtxtMock, streamCtxtMock);
+    for(int i = 0; i < BUFFERS_COUNT; ++i)
+        ASSERT_TRUE(muxer.pushMediaData<0>(inputData));
+    ASSERT_TRUE(muxer.finishInput<0>());
+
+    auto flushed = muxer.flush();
+    ASSERT_EQ(flushed.wait_for(FLUSH_TIMEOUT), std::future_status::ready);
+    flushed.get();
+    ASSERT_EQ(packetsCountWhenFinished, BUFFERS_COUNT);
+    ASSERT_FALSE(isFinishedOnCallerThread);
+}
+
+TEST_F(AsyncMuxerTestFixture, PushedPacketShouldBeCopiedAndQueuedOnWorkerThread)
+{
+    constexpr int64_t PTS = 3;
+    std::atomic<bool> isQueuedOnCallerThread = false;
+    ByteVector packetData;
+    auto callerThread = std::this_thread::get_id();
+    EXPECT_CALL(*streamCtxtMock, setCodecParameters(_));
+    EXPECT_CALL(*streamCtxtMock, queuePacket(_)).WillOnce([&](const EncodedPacket& packet)
+    {
+        isQueuedOnCallerThread = std::this_thread::get_id() == callerThread;
+        packetData.assign(packet.data.data, packet.data.data + packet.data.size);
+        EXPECT_EQ(packet.pts, PTS);
+        EXPECT_TRUE(packet.isKeyframe);
+    });
+    EXPECT_CALL(*streamCtxtMock, getNextFrame()).WillRepeatedly(Return(AVPacket {.size = 0}));
+
+    AsyncMuxerTest muxer(containerCtxtMock, streamCtxtMock);
+    muxer.setCodecParameters<0>(CodecParameters {});
+    {
+        ByteVector input = inputData;
+        ASSERT_TRUE(muxer.pushPacket<0>(input.data(), input.size(), PTS, PTS, true));
+    }
+
+    auto flushed = muxer.flush();
+    ASSERT_EQ(flushed.wait_for(FLUSH_TIMEOUT), std::future_status::ready);
+    flushed.get();
+    ASSERT_EQ(packetData, inputData);
+    ASSERT_FALSE(isQueuedOnCallerThread);
+}
+
+TEST_F(AsyncMuxerTestFixture, SegmentShouldBeCutOnWorkerThreadAfterPushedDataIsMuxed)
+{
+    std::atomic<int> packetsCount = 0;
+    std::atomic<int> packetsCountWhenCut = -1;
+    std::atomic<bool> isCutOnCallerThread = false;
+    auto callerThread = std::this_thread::get_id();
+    expectFramePerBuffer();
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillRepeatedly([&packetsCount](AVPacket&&)
+    {
+        ++packetsCount;
+        return false;
+    });
+    EXPECT_CALL(*containerCtxtMock, cutSegment()).WillOnce([&]
+    {
+        isCutOnCallerThread = std::this_thread::get_id() == callerThread;
+        packetsCountWhenCut = packetsCount.load();
+        return true;
+    });
+
+    AsyncMuxerTest muxer(containerCtxtMock, streamCtxtMock);
+    for(int i = 0; i < BUFFERS_COUNT; ++i)
+        ASSERT_TRUE(muxer.pushMediaData<0>(inputData));
+
+    auto cut = muxer.cutSegment();
+    ASSERT_EQ(cut.wait_for(FLUSH_TIMEOUT), std::future_status::ready);
+    cut.get();
+    ASSERT_EQ(packetsCountWhenCut, BUFFERS_COUNT);
+    ASSERT_FALSE(isCutOnCallerThread);
+}
+
+TEST_F(AsyncMuxerTestFixture, FinishShouldWriteTrailerToSinkOnWorkerThreadAfterPushedDataIsMuxed)
+{
+    const ByteVector trailer = {'m', 'f', 'r', 'a'};
+    std::atomic<int> packetsCount = 0;
+    std::atomic<int> packetsCountWhenFinished = -1;
+    std::atomic<bool> isFinishedOnCallerThread = false;
+    ByteVector deliveredData;
+    auto callerThread = std::this_thread::get_id();
+    auto sink = std::make_shared<CallbackSink>([&deliveredData](const ByteArray& data)
+    {
+        deliveredData.insert(deliveredData.end(), data.begin(), data.end());
+        return true;
+    });
+    expectFramePerBuffer();
+    EXPECT_CALL(*streamCtxtMock, finishInput());
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillRepeatedly([&packetsCount](AVPacket&&)
+    {
+        ++packetsCount;
+        return false;
+    });
+    //Container writes its trailer through muxer's sink
+    EXPECT_CALL(*containerCtxtMock, finish()).WillOnce([&]
+    {
+        isFinishedOnCallerThread = std::this_thread::get_id() == callerThread;
+        packetsCountWhenFinished = packetsCount.load();
+        sink->write(trailer.data(), trailer.size());
+        return false;
+    });
+
+    AsyncMuxerTest muxer(containerCtxtMock, streamCtxtMock, sink);
+    for(int i = 0; i < BUFFERS_COUNT; ++i)
+        ASSERT_TRUE(muxer.pushMediaData<0>(inputData));
+    ASSERT_TRUE(muxer.finishInput<0>());
+
+    auto finished = muxer.finish();
+    ASSERT_EQ(finished.wait_for(FLUSH_TIMEOUT), std::future_status::ready);
+    finished.get();
+    ASSERT_EQ(packetsCountWhenFinished, BUFFERS_COUNT);
+    ASSERT_FALSE(isFinishedOnCallerThread);
+    ASSERT_EQ(deliveredData, trailer);
+}
+
+TEST_F(AsyncMuxerTestFixture, MuxingErrorShouldFailFlushAndStopAcceptingInput)
+{
+    expectFramePerBuffer();
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillOnce(Throw(MuxerException("Couldn't mux media data")));
+
+    AsyncMuxerTest muxer(containerCtxtMock, streamCtxtMock);
+    ASSERT_TRUE(muxer.pushMediaData<0>(inputData));
+    auto flushed = muxer.flush();
+    ASSERT_EQ(flushed.wait_for(FLUSH_TIMEOUT), std::future_status::ready);
+    ASSERT_THROW(flushed.get(), MuxerException);
+
+    ASSERT_NE(muxer.getError(), nullptr);
+    ASSERT_FALSE(muxer.pushMediaData<0>(inputData));
+    ASSERT_FALSE(muxer.finishInput<0>());
+    ASSERT_THROW(muxer.flush().get(), MuxerException);
+}
+
+TEST_F(AsyncMuxerTestFixture, MuxerLoggerShouldGetMessagesLoggedOnWorkerThread)
+{
+    auto logger = std::make_shared<StrictMock<LoggerMock>>();
+    auto callerThread = std::this_thread::get_id();
+    std::atomic<bool> isLoggedOnCallerThread = false;
+    expectFramePerBuffer();
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillOnce([](AVPacket&&)
+    {
+        log(LogLevel::WARNING, "packet muxed");
+        return false;
+    });
+    EXPECT_CALL(*logger, logAVMuxerMessage("packet muxed", LogLevel::WARNING)).WillOnce([&](const std::string&, LogLevel)
+    {
+        isLoggedOnCallerThread = std::this_thread::get_id() == callerThread;
+    });
+
+    AsyncMuxerTest muxer(containerCtxtMock, streamCtxtMock);
+    muxer.setLogger(logger);
+    ASSERT_TRUE(muxer.pushMediaData<0>(inputData));
+    auto flushed = muxer.flush();
+    ASSERT_EQ(flushed.wait_for(FLUSH_TIMEOUT), std::future_status::ready);
+    flushed.get();
+    ASSERT_FALSE(isLoggedOnCallerThread);
+}
+}
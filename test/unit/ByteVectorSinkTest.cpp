@@ -0,0 +1,33 @@
+#include <numeric>
+#include <gtest/gtest.h>
+#include "OutputSink.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+TEST(ByteVectorSinkTest, PartialReadsInterleavedWithWritesShouldReturnDataInOrderAndLeaveRestForTakeData)
+{
+    ByteVector input(1000);
+    std::iota(input.begin(), input.end(), 0);
+    ByteVectorSink sink;
+    ByteVector output;
+    uint8_t buffer[30];
+    for(size_t written = 0; written < input.size(); written += 100)
+    {
+        ASSERT_EQ(sink.write(input.data() + written, 100), 100);
+        for(int i = 0; i < 2; ++i)
+        {
+            ASSERT_EQ(sink.read(buffer, sizeof(buffer)), sizeof(buffer));
+            output.insert(output.end(), buffer, buffer + sizeof(buffer));
+        }
+        ASSERT_EQ(sink.getPendingDataSize(), written + 100 - output.size());
+    }
+
+    auto rest = sink.takeData();
+    output.insert(output.end(), rest.begin(), rest.end());
+    ASSERT_EQ(output, input);
+    ASSERT_FALSE(sink.hasPendingData());
+    ASSERT_EQ(sink.read(buffer, sizeof(buffer)), 0);
+}
+}
@@ -0,0 +1,54 @@
+#include <algorithm>
+#include <numeric>
+#include <gtest/gtest.h>
+#include "ChunkedByteQueue.hpp"
+#include "DataStructures.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr auto DATA_SIZE = 3 * ChunkedByteQueue::CHUNK_SIZE + 123;
+
+ByteVector makeSequence(size_t size)
+{
+    ByteVector data(size);
+    std::iota(data.begin(), data.end(), 0);
+    return data;
+}
+}
+
+TEST(ChunkedByteQueueTest, QueueShouldReturnDataInOrderItWasAppended)
+{
+    ChunkedByteQueue queue;
+    auto input = makeSequence(DATA_SIZE);
+    queue.append(input.data(), input.size() / 2);
+    queue.append(input.data() + input.size() / 2, input.size() - input.size() / 2);
+    ASSERT_EQ(queue.size(), input.size());
+
+    ByteVector output(input.size());
+    size_t readSize = 0;
+    while(!queue.empty())
+        readSize += queue.read(output.data() + readSize, std::min<size_t>(1000, output.size() - readSize));
+    
+    ASSERT_EQ(readSize, input.size());
+    ASSERT_EQ(output, input);
+}
+
+TEST(ChunkedByteQueueTest, QueueShouldNotReadMoreThanRequestedOrAvailable)
+{
+    ChunkedByteQueue queue;
+    auto input = makeSequence(100);
+    queue.append(input.data(), input.size());
+
+    ByteVector output(input.size() * 2);
+    ASSERT_EQ(queue.read(output.data(), 10), 10);
+    ASSERT_EQ(queue.size(), input.size() - 10);
+    ASSERT_EQ(queue.read(output.data() + 10, output.size() - 10), input.size() - 10);
+    ASSERT_TRUE(queue.empty());
+    ASSERT_EQ(queue.read(output.data(), output.size()), 0);
+    ASSERT_TRUE(std::equal(input.begin(), input.end(), output.begin()));
+}
+}
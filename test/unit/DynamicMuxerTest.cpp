@@ -0,0 +1,286 @@
+#include <chrono>
+#include <gtest/gtest.h>
+#include "DynamicMuxer.hpp"
+#include "MuxerException.hpp"
+#include "MediaStreamMock.hpp"
+#include "MediaContainerMock.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr auto FPS                  = 24;
+constexpr auto STREAMS_COUNT        = 5;
+constexpr auto MAX_INTERLEAVE_DELTA = 2 * AV_TIME_BASE;
+}
+
+class DynamicMuxerTest : public DynamicMuxer
+{
+    public:
+        DynamicMuxerTest(std::shared_ptr<MediaContainerWrapper> containerCtxtMock) : DynamicMuxer("mp4")
+        {
+            containerCtxt = containerCtxtMock;
+        }
+
+        void advanceTime(std::chrono::milliseconds duration)
+        {
+            currentTime += duration;
+        }
+
+    protected:
+        std::chrono::steady_clock::time_point getCurrentTime() const override
+        {
+            return currentTime;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+};
+
+class DynamicMuxerTestFixture : public Test
+{
+    public:
+        DynamicMuxerTestFixture()
+        {
+            for(auto& mock : streamCtxtMocks)
+            {
+                mock = std::make_shared<StrictMock<MediaStreamMock>>();
+                EXPECT_CALL(onStreamCtxtMock(mock), boolOp()).WillRepeatedly(Return(true));
+                EXPECT_CALL(onStreamCtxtMock(mock), fillBuffer(_)).Times(AnyNumber());
+                EXPECT_CALL(onStreamCtxtMock(mock), getTimeBase()).WillRepeatedly(Return(AVRational {1, FPS}));
+                EXPECT_CALL(onStreamCtxtMock(mock), getBufferedDataSize()).WillRepeatedly(Return(0));
+            }
+
+            EXPECT_CALL(onContainerCtxtMock(), boolOp()).WillRepeatedly(Return(true));
+            EXPECT_CALL(onContainerCtxtMock(), getMaxInterleaveDelta()).WillRepeatedly(Return(MAX_INTERLEAVE_DELTA));
+        }
+
+    protected:
+        StrictMock<MediaContainerMock>& onContainerCtxtMock()
+        {
+            return *reinterpret_cast<StrictMock<MediaContainerMock>*>(&*containerCtxtMock);
+        }
+
+        static StrictMock<MediaStreamMock>& onStreamCtxtMock(const WrappedMediaStreamSharedPtr& mock)
+        {
+            return *reinterpret_cast<StrictMock<MediaStreamMock>*>(&*mock);
+        }
+
+        void addAllStreams(DynamicMuxer& muxer)
+        {
+            for(auto& mock : streamCtxtMocks)
+            {
+                EXPECT_CALL(onContainerCtxtMock(), createStream()).WillOnce(Return(mock)).RetiresOnSaturation();
+                muxer.addStream();
+            }
+        }
+
+        std::shared_ptr<MediaContainerWrapper>                containerCtxtMock = std::make_shared<StrictMock<MediaContainerMock>>("mp4");
+        std::array<WrappedMediaStreamSharedPtr, STREAMS_COUNT> streamCtxtMocks;
+
+        const ByteVector inputData = {0, 1, 2, 3, 4, 5, 6, 7};
+};
+
+TEST_F(DynamicMuxerTestFixture, MuxerShouldAddStreamsAtRuntimeAndRejectInvalidOnes)
+{
+    DynamicMuxerTest muxer(containerCtxtMock);
+    EXPECT_CALL(onContainerCtxtMock(), createStream(_)).WillOnce(Return(streamCtxtMocks[0]));
+    EXPECT_CALL(onContainerCtxtMock(), createStream()).WillOnce(Return(streamCtxtMocks[1]));
+
+    ASSERT_THROW(muxer.addStream(AVRational {0, 1}), std::invalid_argument);
+    ASSERT_EQ(muxer.addStream(AVRational {FPS, 1}), 0);
+    ASSERT_EQ(muxer.addStream(), 1);
+    ASSERT_EQ(muxer.getStreamsCount(), 2);
+    ASSERT_THROW(muxer.muxMediaData(2, inputData), std::out_of_range);
+}
+
+TEST_F(DynamicMuxerTestFixture, MuxerShouldHoldBackStreamRunningAheadUntilSlowestOneCatchesUp)
+{
+    DynamicMuxerTest muxer(containerCtxtMock);
+    addAllStreams(muxer);
+
+    //First stream would produce 3 seconds of packets, but can't get more than interleave window ahead of others
+    auto fastStream = streamCtxtMocks.front();
+    EXPECT_CALL(onStreamCtxtMock(fastStream), getNextFrame()).WillRepeatedly(Return(AVPacket {.size = 1, .duration = FPS}));
+    EXPECT_CALL(onContainerCtxtMock(), muxFramePacket(_)).Times(2).WillRepeatedly(Return(false));
+    muxer.muxMediaData(0, inputData);
+    Mock::VerifyAndClearExpectations(&onContainerCtxtMock());
+
+    ASSERT_THROW(muxer.addStream(), MuxerException);
+
+    //Other streams catch up by one second each, which lets first one go one more second ahead
+    for(unsigned i = 1; i < STREAMS_COUNT; ++i)
+    {
+        EXPECT_CALL(onStreamCtxtMock(streamCtxtMocks[i]), getNextFrame()).WillOnce(Return(AVPacket {.size = 1, .duration = FPS}))
+                                                                          .WillOnce(Return(AVPacket {.size = 0}));
+    }
+    EXPECT_CALL(onContainerCtxtMock(), muxFramePacket(_)).Times(STREAMS_COUNT).WillRepeatedly(Return(false));
+    for(unsigned i = 1; i < STREAMS_COUNT; ++i)
+        muxer.muxMediaData(i, inputData);
+    muxer.muxMediaData(0, inputData);
+}
+
+TEST_F(DynamicMuxerTestFixture, MuxerShouldReportMuxedPacketsAndHoldingStreamsBackInMetrics)
+{
+    DynamicMuxerTest muxer(containerCtxtMock);
+    addAllStreams(muxer);
+
+    auto fastStream = streamCtxtMocks.front();
+    EXPECT_CALL(onStreamCtxtMock(fastStream), getNextFrame()).WillRepeatedly(Return(AVPacket {.size = 1, .duration = FPS}));
+    EXPECT_CALL(onContainerCtxtMock(), muxFramePacket(_)).Times(2).WillRepeatedly(Return(false));
+    muxer.muxMediaData(0, inputData);
+    muxer.muxMediaData(0, inputData);
+
+    auto metrics = muxer.getMetrics();
+    ASSERT_EQ(metrics.packetsMuxed, 2);
+    ASSERT_EQ(metrics.streams.size(), STREAMS_COUNT);
+    ASSERT_EQ(metrics.streams[0].packetsMuxed, 2);
+    ASSERT_EQ(metrics.streams[0].limitedCount, 2);
+    ASSERT_EQ(metrics.streams[0].relativeTimeAhead, 2 * AV_TIME_BASE);
+    ASSERT_EQ(metrics.streams[1].packetsMuxed, 0);
+    ASSERT_EQ(metrics.streams[1].limitedCount, 0);
+}
+
+TEST_F(DynamicMuxerTestFixture, MuxerShouldRefuseInputOverBudgetAndReportWatermarks)
+{
+    constexpr size_t STREAM_BUDGET = 20;
+    constexpr size_t HIGH_WATERMARK = 16;
+    DynamicMuxerTest muxer(containerCtxtMock);
+    addAllStreams(muxer);
+
+    unsigned highWatermarksCount = 0, lowWatermarksCount = 0;
+    BufferLimits limits { STREAM_BUDGET, 0, HIGH_WATERMARK, 0 };
+    limits.onHighWatermark = [&highWatermarksCount] { ++highWatermarksCount; };
+    limits.onLowWatermark = [&lowWatermarksCount] { ++lowWatermarksCount; };
+    muxer.setBufferLimits(std::move(limits));
+
+    //Fast stream's input is only buffered - its packets don't consume it, until it's flushed with empty input
+    size_t fastStreamBufferedSize = 0;
+    auto fastStream = streamCtxtMocks.front();
+    EXPECT_CALL(onStreamCtxtMock(fastStream), fillBuffer(_)).WillRepeatedly([&fastStreamBufferedSize](const ByteArray& data)
+    {
+        fastStreamBufferedSize = (data.size > 0 ? fastStreamBufferedSize + data.size : 0);
+    });
+    EXPECT_CALL(onStreamCtxtMock(fastStream), getBufferedDataSize()).WillRepeatedly(ReturnPointee(&fastStreamBufferedSize));
+    EXPECT_CALL(onStreamCtxtMock(fastStream), getNextFrame()).WillRepeatedly(Return(AVPacket {.size = 1, .duration = FPS}));
+    EXPECT_CALL(onContainerCtxtMock(), muxFramePacket(_)).Times(2).WillRepeatedly(Return(false));
+
+    ASSERT_EQ(muxer.tryMuxMediaData(0, inputData), TryMuxResult::ACCEPTED);
+    ASSERT_EQ(muxer.tryMuxMediaData(0, inputData), TryMuxResult::ACCEPTED);
+    ASSERT_EQ(highWatermarksCount, 1);
+    ASSERT_EQ(muxer.getBufferedInputSize(), 2 * inputData.size());
+    ASSERT_EQ(muxer.tryMuxMediaData(0, inputData), TryMuxResult::WOULD_EXCEED_BUDGET);
+    ASSERT_EQ(fastStreamBufferedSize, 2 * inputData.size());
+
+    //Budget applies to stream that others wait for as well
+    auto slowStream = streamCtxtMocks.back();
+    EXPECT_CALL(onStreamCtxtMock(slowStream), getBufferedDataSize()).WillRepeatedly(Return(STREAM_BUDGET));
+    ASSERT_EQ(muxer.tryMuxMediaData(STREAMS_COUNT - 1, inputData), TryMuxResult::WOULD_EXCEED_BUDGET);
+
+    muxer.muxMediaData(0, ByteVector {});
+    ASSERT_EQ(muxer.getBufferedInputSize(), 0);
+    ASSERT_EQ(lowWatermarksCount, 1);
+    ASSERT_THROW(muxer.setBufferLimits({}), MuxerException);
+}
+
+TEST_F(DynamicMuxerTestFixture, BudgetsShouldApplyBeforeHeaderIsWrittenWhileSomeStreamGetsNoData)
+{
+    constexpr size_t STREAM_BUDGET = 20;
+    constexpr size_t MUXER_BUDGET = 24;
+    DynamicMuxerTest muxer(containerCtxtMock);
+    addAllStreams(muxer);
+    muxer.setBufferLimits(BufferLimits { STREAM_BUDGET, MUXER_BUDGET });
+
+    //Last stream never gets any data, so header isn't written and input is only buffered
+    EXPECT_CALL(onContainerCtxtMock(), boolOp()).WillRepeatedly(Return(false));
+    std::array<size_t, 2> bufferedSizes = {};
+    for(unsigned i = 0; i < bufferedSizes.size(); ++i)
+    {
+        auto& bufferedSize = bufferedSizes[i];
+        EXPECT_CALL(onStreamCtxtMock(streamCtxtMocks[i]), fillBuffer(_)).WillRepeatedly([&bufferedSize](const ByteArray& data)
+        {
+            bufferedSize += data.size;
+        });
+        EXPECT_CALL(onStreamCtxtMock(streamCtxtMocks[i]), getBufferedDataSize()).WillRepeatedly(ReturnPointee(&bufferedSize));
+    }
+
+    ASSERT_EQ(muxer.tryMuxMediaData(0, inputData), TryMuxResult::ACCEPTED);
+    ASSERT_EQ(muxer.tryMuxMediaData(0, inputData), TryMuxResult::ACCEPTED);
+    ASSERT_EQ(muxer.tryMuxMediaData(0, inputData), TryMuxResult::WOULD_EXCEED_BUDGET);
+    ASSERT_EQ(bufferedSizes[0], 2 * inputData.size());
+
+    //Muxer budget is shared by all streams
+    ASSERT_EQ(muxer.tryMuxMediaData(1, inputData), TryMuxResult::ACCEPTED);
+    ASSERT_EQ(muxer.tryMuxMediaData(1, inputData), TryMuxResult::WOULD_EXCEED_BUDGET);
+    ASSERT_EQ(muxer.getBufferedInputSize(), MUXER_BUDGET);
+}
+
+TEST_F(DynamicMuxerTestFixture, FinishingMuxerShouldFinishContainerAndReportDataItWrote)
+{
+    DynamicMuxerTest muxer(containerCtxtMock);
+    addAllStreams(muxer);
+
+    EXPECT_CALL(onContainerCtxtMock(), finish()).WillOnce(Return(true));
+    ASSERT_FALSE(muxer.hasMuxedData());
+    ASSERT_TRUE(muxer.finish());
+    ASSERT_TRUE(muxer.hasMuxedData());
+}
+
+TEST_F(DynamicMuxerTestFixture, DataBufferedWhileProbingShouldCountAgainstLimitsSetAfterIt)
+{
+    constexpr size_t PROBED_SIZE = 100;
+    constexpr size_t HIGH_WATERMARK = 16;
+    DynamicMuxerTest muxer(containerCtxtMock);
+    addAllStreams(muxer);
+
+    //Stream is still being probed, so its input only gets buffered
+    auto probedStream = streamCtxtMocks.front();
+    size_t probedStreamBufferedSize = PROBED_SIZE;
+    EXPECT_CALL(onStreamCtxtMock(probedStream), getBufferedDataSize()).WillRepeatedly(ReturnPointee(&probedStreamBufferedSize));
+
+    ASSERT_THROW(muxer.setBufferLimits(BufferLimits { 0, 0, HIGH_WATERMARK, HIGH_WATERMARK }), std::invalid_argument);
+    muxer.setBufferLimits(BufferLimits { 0, 0, HIGH_WATERMARK, 0 });
+    ASSERT_EQ(muxer.getBufferedInputSize(), PROBED_SIZE);
+
+    //Once buffered data is demuxed, total size drops back instead of wrapping around
+    EXPECT_CALL(onStreamCtxtMock(probedStream), getNextFrame()).WillOnce([&probedStreamBufferedSize]
+    {
+        probedStreamBufferedSize = 0;
+        return AVPacket {.size = 0};
+    });
+    muxer.muxMediaData(0, ByteVector {});
+    ASSERT_EQ(muxer.getBufferedInputSize(), 0);
+}
+
+TEST_F(DynamicMuxerTestFixture, MuxerShouldLeaveStalledStreamsOutOfInterleavingUntilTheyReceiveDataAgain)
+{
+    constexpr auto STARVATION_TIMEOUT = std::chrono::milliseconds(50);
+    DynamicMuxerTest muxer(containerCtxtMock);
+    addAllStreams(muxer);
+    muxer.setStarvationTimeout(STARVATION_TIMEOUT);
+
+    auto fastStream = streamCtxtMocks.front();
+    EXPECT_CALL(onStreamCtxtMock(fastStream), getNextFrame()).WillRepeatedly(Return(AVPacket {.size = 1, .duration = FPS}));
+    EXPECT_CALL(onContainerCtxtMock(), muxFramePacket(_)).Times(4).WillRepeatedly(Return(false));
+    muxer.muxMediaData(0, inputData);
+    ASSERT_EQ(muxer.getMetrics().streams[0].limitedCount, 1);
+
+    //Other streams don't receive anything, so after timeout first one is no longer held back by them
+    muxer.advanceTime(2 * STARVATION_TIMEOUT);
+    EXPECT_CALL(onStreamCtxtMock(fastStream), getNextFrame()).WillOnce(Return(AVPacket {.size = 1, .duration = FPS}))
+                                                             .WillOnce(Return(AVPacket {.size = 1, .duration = FPS}))
+                                                             .WillOnce(Return(AVPacket {.size = 0}));
+    muxer.muxMediaData(0, inputData);
+    auto metrics = muxer.getMetrics();
+    ASSERT_EQ(metrics.streams[0].limitedCount, 1);
+    ASSERT_EQ(metrics.streams[0].relativeTimeAhead, 4 * AV_TIME_BASE);
+    ASSERT_EQ(metrics.streams[1].stalledCount, 1);
+
+    //Stream which receives data again rejoins along with the slowest active stream
+    EXPECT_CALL(onStreamCtxtMock(streamCtxtMocks[1]), getNextFrame()).WillOnce(Return(AVPacket {.size = 0}));
+    muxer.muxMediaData(1, inputData);
+    ASSERT_EQ(muxer.getMetrics().streams[1].relativeTimeAhead, 4 * AV_TIME_BASE);
+}
+}
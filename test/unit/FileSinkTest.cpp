@@ -0,0 +1,128 @@
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include "FileSink.hpp"
+#include "MuxerException.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+class FileSinkTest : public Test
+{
+    protected:
+        void TearDown() override
+        {
+            unlink(path.c_str());
+        }
+
+        ByteVector readFile() const
+        {
+            std::ifstream file(path, std::ios::binary);
+            return ByteVector(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        std::string path = "/tmp/avmuxer-file-sink-test-" + std::to_string(getpid());
+};
+}
+
+TEST_F(FileSinkTest, SinkShouldWriteAllDataInOrderAcrossBatchesAndSegments)
+{
+    ByteVector input(5 * PAGE_SIZE + 77);
+    std::iota(input.begin(), input.end(), 0);
+    {
+        FileSink sink(path, FileSinkOptions { 2 * PAGE_SIZE, 4 * PAGE_SIZE, FsyncPolicy::EVERY_SEGMENT });
+        size_t written = 0;
+        for(size_t step = 1000; written < input.size(); written += step)
+        {
+            auto size = std::min(step, input.size() - written);
+            ASSERT_EQ(sink.write(input.data() + written, size), size);
+            if(written % 3000 == 0)
+                sink.closeSegment(SegmentInfo {});
+        }
+
+        ASSERT_EQ(sink.flush(), 0);
+        ASSERT_EQ(readFile(), input);
+        ASSERT_EQ(sink.write(input.data(), 10), 10);
+    }
+
+    auto output = readFile();
+    ASSERT_EQ(output.size(), input.size() + 10);
+    ASSERT_EQ(ByteVector(output.begin() + input.size(), output.end()), ByteVector(input.begin(), input.begin() + 10));
+}
+
+TEST_F(FileSinkTest, SinksWrittenFromManyThreadsShouldEachGetTheirOwnData)
+{
+    //More files than writer threads, so some of them share one
+    constexpr unsigned FILES_COUNT = 8;
+    ByteVector input(9 * PAGE_SIZE + 5);
+    std::iota(input.begin(), input.end(), 0);
+    std::vector<std::thread> producers;
+    for(unsigned i = 0; i < FILES_COUNT; ++i)
+    {
+        producers.emplace_back([this, i, &input]
+        {
+            FileSink sink(path + "-" + std::to_string(i), FileSinkOptions { 2 * PAGE_SIZE, 4 * PAGE_SIZE, FsyncPolicy::EVERY_BATCH });
+            for(size_t written = 0; written < input.size(); written += PAGE_SIZE)
+                sink.write(input.data() + written, std::min<size_t>(PAGE_SIZE, input.size() - written));
+        });
+    }
+
+    for(auto& producer : producers)
+        producer.join();
+
+    auto mainPath = path;
+    for(unsigned i = 0; i < FILES_COUNT; ++i)
+    {
+        path = mainPath + "-" + std::to_string(i);
+        EXPECT_EQ(readFile(), input) << "File " << i << " differs";
+        unlink(path.c_str());
+    }
+    path = mainPath;
+}
+
+TEST_F(FileSinkTest, WatermarkCallbacksShouldBeCalledInPairsAsPendingDataRisesAndIsWrittenOut)
+{
+    ByteVector input(8 * PAGE_SIZE);
+    std::iota(input.begin(), input.end(), 0);
+    std::atomic<int> highWatermarksCount = 0;
+    std::atomic<int> lowWatermarksCount = 0;
+    FileSinkOptions options { PAGE_SIZE, 4 * PAGE_SIZE, FsyncPolicy::NEVER };
+    //Every submitted batch reaches high watermark, so it's crossed at least once
+    options.highWatermark = PAGE_SIZE;
+    options.onHighWatermark = [&] { ASSERT_EQ(++highWatermarksCount, lowWatermarksCount + 1); };
+    options.onLowWatermark = [&] { ASSERT_EQ(++lowWatermarksCount, highWatermarksCount.load()); };
+    FileSink sink(path, options);
+    for(size_t written = 0; written < input.size(); written += 1000)
+    {
+        auto size = std::min<size_t>(1000, input.size() - written);
+        ASSERT_EQ(sink.write(input.data() + written, size), size);
+    }
+
+    ASSERT_EQ(sink.flush(), 0);
+    ASSERT_GE(highWatermarksCount, 1);
+    ASSERT_EQ(lowWatermarksCount, highWatermarksCount.load());
+    ASSERT_EQ(readFile(), input);
+}
+
+TEST_F(FileSinkTest, SinkShouldThrowWhenLowWatermarkIsNotBelowHighOne)
+{
+    FileSinkOptions options;
+    options.highWatermark = options.lowWatermark = PAGE_SIZE;
+    ASSERT_THROW(FileSink(path, options), std::invalid_argument);
+}
+
+TEST_F(FileSinkTest, SinkShouldThrowWhenFileCantBeOpened)
+{
+    ASSERT_THROW(FileSink("/nonexistent-directory/output.mp4"), MuxerException);
+}
+}
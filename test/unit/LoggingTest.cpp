@@ -0,0 +1,110 @@
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "AsyncLogger.hpp"
+#include "utils.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+class LoggerMock : public ILogger
+{
+    public:
+        MOCK_METHOD(void, logAVMuxerMessage, (const std::string& msg, LogLevel level), (override));
+};
+
+class CollectingLogger : public ILogger
+{
+    public:
+        std::vector<std::string> messages;
+
+        void logAVMuxerMessage(const std::string& msg, LogLevel) override
+        {
+            messages.push_back(msg);
+        }
+};
+
+class LoggingTest : public Test
+{
+    protected:
+        void TearDown() override
+        {
+            setLogger(nullptr);
+            setLogLevel(LogLevel::DEBUG);
+        }
+};
+}
+
+TEST_F(LoggingTest, MessageShouldBeFormattedAndPassedToLoggerOnlyIfItsLevelIsEnabled)
+{
+    auto logger = std::make_shared<StrictMock<LoggerMock>>();
+    ASSERT_FALSE(isLogLevelEnabled(LogLevel::ERROR));
+    setLogger(logger);
+    setLogLevel(LogLevel::WARNING);
+    ASSERT_FALSE(isLogLevelEnabled(LogLevel::INFO));
+    ASSERT_TRUE(isLogLevelEnabled(LogLevel::WARNING));
+
+    EXPECT_CALL(*logger, logAVMuxerMessage("stream 3 is 1500 us ahead", LogLevel::ERROR));
+    log(LogLevel::INFO, "stream ", 3, " identified");
+    log(LogLevel::ERROR, "stream ", 3, " is ", int64_t { 1500 }, std::string(" us ahead"));
+}
+
+TEST_F(LoggingTest, LoggerScopeShouldRedirectMessagesLoggedByCurrentThread)
+{
+    auto globalLogger = std::make_shared<StrictMock<LoggerMock>>();
+    StrictMock<LoggerMock> scopedLogger;
+    setLogger(globalLogger);
+
+    {
+        InSequence sequence;
+        EXPECT_CALL(scopedLogger, logAVMuxerMessage("in scope", LogLevel::INFO));
+        EXPECT_CALL(*globalLogger, logAVMuxerMessage("other thread", LogLevel::INFO));
+        EXPECT_CALL(*globalLogger, logAVMuxerMessage("after scope", LogLevel::INFO));
+    }
+
+    {
+        LoggerScope scope(&scopedLogger);
+        log(LogLevel::INFO, "in scope");
+        std::thread([] { log(LogLevel::INFO, "other thread"); }).join();
+    }
+    log(LogLevel::INFO, "after scope");
+}
+
+TEST_F(LoggingTest, AsyncLoggerShouldDeliverMessagesOfAllThreadsInTheirOrder)
+{
+    constexpr int THREADS_COUNT = 4;
+    constexpr int MESSAGES_PER_THREAD = 200;
+    auto collectingLogger = std::make_shared<CollectingLogger>();
+    {
+        AsyncLogger asyncLogger(collectingLogger);
+        std::vector<std::thread> threads;
+        for(int t = 0; t < THREADS_COUNT; ++t)
+        {
+            threads.emplace_back([&asyncLogger, t]
+            {
+                for(int i = 0; i < MESSAGES_PER_THREAD; ++i)
+                    asyncLogger.logAVMuxerMessage(std::to_string(t) + ":" + std::to_string(i), LogLevel::INFO);
+            });
+        }
+        for(auto& thread : threads)
+            thread.join();
+        
+        ASSERT_EQ(asyncLogger.getDroppedCount(), 0);
+    }
+
+    ASSERT_EQ(collectingLogger->messages.size(), THREADS_COUNT * MESSAGES_PER_THREAD);
+    std::vector<int> nextMessage(THREADS_COUNT, 0);
+    for(const auto& msg : collectingLogger->messages)
+    {
+        auto separator = msg.find(':');
+        auto thread = std::stoi(msg.substr(0, separator));
+        ASSERT_EQ(std::stoi(msg.substr(separator + 1)), nextMessage[thread]++);
+    }
+}
+}
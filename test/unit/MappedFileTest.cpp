@@ -0,0 +1,76 @@
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include "MappedFile.hpp"
+#include "MediaDataQueue.hpp"
+#include "MuxerException.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr auto FILE_SIZE = 3 * PAGE_SIZE + 123;
+
+class MappedFileTest : public Test
+{
+    protected:
+        void SetUp() override
+        {
+            ByteVector data(FILE_SIZE);
+            std::iota(data.begin(), data.end(), 0);
+            content = data;
+            std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+        }
+
+        void TearDown() override
+        {
+            unlink(path.c_str());
+        }
+
+        std::string path = "/tmp/avmuxer-mapped-file-test-" + std::to_string(getpid());
+        ByteVector  content;
+};
+}
+
+TEST_F(MappedFileTest, MappedFileShouldServeItsPartsWithoutCopying)
+{
+    auto file = MappedFile::open(path);
+    ASSERT_EQ(file->size(), FILE_SIZE);
+
+    auto whole = file->getData();
+    ASSERT_EQ(ByteVector(whole.begin(), whole.end()), content);
+
+    auto part = file->getData(PAGE_SIZE + 1, PAGE_SIZE);
+    ASSERT_EQ(part.data, whole.data + PAGE_SIZE + 1);
+    ASSERT_EQ(part.size, PAGE_SIZE);
+
+    auto tail = file->getData(3 * PAGE_SIZE, PAGE_SIZE);
+    ASSERT_EQ(tail.size, 123);
+    ASSERT_TRUE(file->getData(2 * FILE_SIZE, 1).empty());
+}
+
+TEST_F(MappedFileTest, MappedFilePartsShouldStayReadableAfterFileIsReleased)
+{
+    MediaDataQueue queue;
+    {
+        auto file = MappedFile::open(path);
+        for(size_t offset = 0; offset < file->size(); offset += PAGE_SIZE)
+            queue.attach(file->getData(offset, PAGE_SIZE));
+    }
+
+    ByteVector output(FILE_SIZE);
+    ASSERT_EQ(queue.read(output.data(), output.size()), FILE_SIZE);
+    ASSERT_EQ(output, content);
+    queue.discardReadData();
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST_F(MappedFileTest, OpeningMissingFileShouldThrow)
+{
+    ASSERT_THROW(MappedFile::open(path + "-missing"), MuxerException);
+}
+}
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "MediaContainerContext.hpp"
+#include "MuxerException.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr AVRational FRAMERATE = {30, 1};
+constexpr AVRational TIMEBASE = {1, 30};
+constexpr int64_t    SEGMENT_DURATION = AV_TIME_BASE;
+constexpr int64_t    CHUNK_DURATION = AV_TIME_BASE / 2;
+constexpr int        GOP_SIZE = 30;
+constexpr int        PACKET_SIZE = 16;
+constexpr int        WIDTH = 320;
+constexpr int        HEIGHT = 240;
+//avcC with no parameter sets - mp4 muxer only copies it, packets aren't decoded
+const ByteVector     AVC_CONFIG = {1, 0x42, 0, 0x1e, 0xff, 0xe0, 0};
+//Mirror's time base differs from source's one, so its timestamps are rescaled (with rounding error up to a millisecond)
+constexpr int64_t    RESCALING_TOLERANCE = AV_TIME_BASE / 1000;
+
+class OutputSinkMock : public IOutputSink
+{
+    public:
+        MOCK_METHOD(int, write, (const uint8_t* data, int size), (override));
+        MOCK_METHOD(void, closeSegment, (const SegmentInfo& info), (override));
+        MOCK_METHOD(void, closeChunk, (const SegmentInfo& info), (override));
+};
+
+MATCHER(IsInitSegment, "")
+{
+    return arg.isInitSegment;
+}
+
+MATCHER_P3(IsMediaSegment, sequenceNumber, startTime, duration, "")
+{
+    return !arg.isInitSegment && arg.sequenceNumber == unsigned(sequenceNumber)
+           && std::abs(arg.startTime - startTime) <= RESCALING_TOLERANCE && std::abs(arg.duration - duration) <= RESCALING_TOLERANCE;
+}
+}
+
+class MediaContainerContextTest : public Test
+{
+    public:
+        MediaContainerContextTest() : sink(std::make_shared<NiceMock<OutputSinkMock>>())
+        {
+            ON_CALL(*sink, write(_, _)).WillByDefault([](const uint8_t*, int size) { return size; });
+        }
+
+    protected:
+        std::shared_ptr<NiceMock<OutputSinkMock>> sink;
+
+        static std::shared_ptr<MediaContainerContext> createContainer(const char* formatName, OutputSinkSharedPtr outputSink)
+        {
+            auto container = std::make_shared<MediaContainerContext>(formatName, outputSink);
+            auto stream = container->createStream(FRAMERATE);
+            stream->setCodecParameters(CodecParameters { AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_H264, TIMEBASE, AVC_CONFIG, WIDTH, HEIGHT });
+            return container;
+        }
+
+        static bool writeHeader(MediaContainerContext& container)
+        {
+            return container;
+        }
+
+        //Packet of given frame, with timestamps in container's time base (as demuxed ones are)
+        static AVPacket makeFramePacket(MediaContainerContext& container, int frame)
+        {
+            auto timebase = container.getFormatContext()->streams[0]->time_base;
+            AVPacket packet;
+            av_new_packet(&packet, PACKET_SIZE);
+            packet.pts = packet.dts = av_rescale_q(frame, TIMEBASE, timebase);
+            packet.duration = av_rescale_q(1, TIMEBASE, timebase);
+            packet.flags = (frame % GOP_SIZE == 0 ? AV_PKT_FLAG_KEY : 0);
+            packet.stream_index = 0;
+            return packet;
+        }
+
+        static int64_t getFrameTime(int frame)
+        {
+            return av_rescale_q(frame, TIMEBASE, AV_TIME_BASE_Q);
+        }
+};
+
+TEST_F(MediaContainerContextTest, ChunkingShouldNotBeEnabledWithoutSegmenting)
+{
+    MediaContainerContext container("mp4");
+    ContainerOptions options;
+    options.chunkDuration = CHUNK_DURATION;
+    ASSERT_THROW(container.setOptions(options), std::invalid_argument);
+
+    options.segmentDuration = SEGMENT_DURATION;
+    ASSERT_NO_THROW(container.setOptions(options));
+}
+
+TEST_F(MediaContainerContextTest, SegmentedMp4ShouldNotBeSetUpWithoutCustomFragments)
+{
+    MediaContainerContext container("mp4");
+    ContainerOptions options;
+    options.segmentDuration = SEGMENT_DURATION;
+    options.formatOptions = {{"movflags", "frag_keyframe+empty_moov"}};
+    ASSERT_THROW(container.setOptions(options), std::invalid_argument);
+
+    options.formatOptions = {{"movflags", "+frag_custom+empty_moov"}};
+    ASSERT_NO_THROW(container.setOptions(options));
+}
+
+TEST_F(MediaContainerContextTest, SegmentedMp4ShouldEmitInitAndMediaSegmentsWhenOnlyOtherOptionsAreGiven)
+{
+    constexpr int FRAMES_COUNT = GOP_SIZE + GOP_SIZE / 2;
+    ContainerOptions options;
+    options.segmentDuration = SEGMENT_DURATION;
+    options.formatOptions = {{"brand", "iso6"}};
+    size_t writtenSize = 0;
+    std::vector<size_t> segmentsSizes;
+    ON_CALL(*sink, write(_, _)).WillByDefault([&writtenSize](const uint8_t*, int size)
+    {
+        writtenSize += size;
+        return size;
+    });
+    {
+        InSequence sequence;
+        EXPECT_CALL(*sink, closeSegment(IsInitSegment()));
+        EXPECT_CALL(*sink, closeSegment(IsMediaSegment(1, 0, SEGMENT_DURATION)));
+        EXPECT_CALL(*sink, closeSegment(IsMediaSegment(2, SEGMENT_DURATION, getFrameTime(FRAMES_COUNT - GOP_SIZE))));
+    }
+    ON_CALL(*sink, closeSegment(_)).WillByDefault([&](const SegmentInfo&) { segmentsSizes.push_back(std::exchange(writtenSize, 0)); });
+
+    auto container = createContainer("mp4", sink);
+    container->setOptions(options);
+    ASSERT_TRUE(writeHeader(*container));
+    for(int frame = 0; frame < FRAMES_COUNT; ++frame)
+        container->muxFramePacket(makeFramePacket(*container, frame));
+    container->cutSegment();
+
+    //Init segment holds ftyp and empty moov, every media segment holds its own fragment
+    ASSERT_EQ(segmentsSizes.size(), 3u);
+    for(auto segmentSize : segmentsSizes)
+        ASSERT_GT(segmentSize, 0u);
+}
+
+TEST_F(MediaContainerContextTest, FinishingShouldWriteLastFragmentToSinkAndRefuseFurtherPackets)
+{
+    constexpr int FRAMES_COUNT = GOP_SIZE + GOP_SIZE / 2;
+    size_t writtenSize = 0;
+    ON_CALL(*sink, write(_, _)).WillByDefault([&writtenSize](const uint8_t*, int size)
+    {
+        writtenSize += size;
+        return size;
+    });
+
+    //Default streaming flags cut fragments on keyframes only, so last GOP stays in muxer until it's finished
+    auto container = createContainer("mp4", sink);
+    ASSERT_TRUE(writeHeader(*container));
+    for(int frame = 0; frame < FRAMES_COUNT; ++frame)
+        container->muxFramePacket(makeFramePacket(*container, frame));
+
+    auto sizeBeforeFinish = writtenSize;
+    container->finish();
+    ASSERT_GE(writtenSize - sizeBeforeFinish, size_t((FRAMES_COUNT - GOP_SIZE) * PACKET_SIZE));
+    ASSERT_THROW(container->muxFramePacket(makeFramePacket(*container, FRAMES_COUNT)), MuxerException);
+
+    //Finishing again doesn't write trailer twice
+    auto sizeAfterFinish = writtenSize;
+    container->finish();
+    ASSERT_EQ(writtenSize, sizeAfterFinish);
+}
+
+TEST_F(MediaContainerContextTest, FinishingSegmentedMp4ShouldDeliverTrailerAsEndOfLastSegment)
+{
+    constexpr int FRAMES_COUNT = GOP_SIZE + GOP_SIZE / 2;
+    //Fragmented mp4 ends with mfra box, which ends with 16 bytes long mfro box
+    constexpr size_t MFRO_SIZE = 16;
+    const ByteVector mfroType = {'m', 'f', 'r', 'o'};
+    std::vector<SegmentSink::Segment> segments;
+    auto segmentSink = std::make_shared<SegmentSink>([&segments](SegmentSink::Segment&& segment)
+    {
+        segments.push_back(std::move(segment));
+    });
+    ContainerOptions options;
+    options.segmentDuration = SEGMENT_DURATION;
+
+    auto container = createContainer("mp4", segmentSink);
+    container->setOptions(options);
+    ASSERT_TRUE(writeHeader(*container));
+    for(int frame = 0; frame < FRAMES_COUNT; ++frame)
+        container->muxFramePacket(makeFramePacket(*container, frame));
+    container->finish();
+
+    ASSERT_FALSE(segmentSink->hasPendingData());
+    ASSERT_EQ(segments.size(), 3u);
+    auto& lastSegment = segments.back();
+    ASSERT_FALSE(lastSegment.info.isInitSegment);
+    ASSERT_EQ(lastSegment.info.sequenceNumber, 2u);
+    ASSERT_GT(lastSegment.data.size(), MFRO_SIZE);
+    auto mfro = lastSegment.data.end() - MFRO_SIZE;
+    ASSERT_TRUE(std::equal(mfroType.begin(), mfroType.end(), mfro + 4));
+}
+
+TEST_F(MediaContainerContextTest, MirrorShouldBeAddedOnlyWithItsOwnSinkAndBeforeHeaderIsWritten)
+{
+    auto container = createContainer("mpegts", sink);
+    ASSERT_THROW(container->addMirrorOutput("matroska", nullptr, {}), std::invalid_argument);
+    container->addMirrorOutput("matroska", std::make_shared<NiceMock<OutputSinkMock>>(), {});
+
+    ASSERT_TRUE(writeHeader(*container));
+    ASSERT_THROW(container->addMirrorOutput("matroska", std::make_shared<NiceMock<OutputSinkMock>>(), {}), MuxerException);
+}
+
+TEST_F(MediaContainerContextTest, MirrorShouldCutSameSegmentsWithRescaledTimestamps)
+{
+    constexpr int FRAMES_COUNT = GOP_SIZE + GOP_SIZE / 2;
+    ContainerOptions options;
+    options.segmentDuration = SEGMENT_DURATION;
+    auto mirrorSink = std::make_shared<NiceMock<OutputSinkMock>>();
+    ON_CALL(*mirrorSink, write(_, _)).WillByDefault([](const uint8_t*, int size) { return size; });
+    for(auto& outputSink : { sink, mirrorSink })
+    {
+        InSequence sequence;
+        EXPECT_CALL(*outputSink, closeSegment(IsInitSegment()));
+        EXPECT_CALL(*outputSink, closeSegment(IsMediaSegment(1, 0, SEGMENT_DURATION)));
+        EXPECT_CALL(*outputSink, closeSegment(IsMediaSegment(2, SEGMENT_DURATION, getFrameTime(FRAMES_COUNT - GOP_SIZE))));
+    }
+
+    auto container = createContainer("mpegts", sink);
+    container->setOptions(options);
+    container->addMirrorOutput("matroska", mirrorSink, options);
+    ASSERT_TRUE(writeHeader(*container));
+    for(int frame = 0; frame < FRAMES_COUNT; ++frame)
+        container->muxFramePacket(makeFramePacket(*container, frame));
+
+    //Last segment is closed in mirror as well
+    container->cutSegment();
+}
+
+TEST_F(MediaContainerContextTest, PacketShouldBeReleasedWhenMirrorFailsToMuxIt)
+{
+    ContainerOptions options;
+    options.segmentDuration = SEGMENT_DURATION;
+    auto mirrorSink = std::make_shared<NiceMock<OutputSinkMock>>();
+    ON_CALL(*mirrorSink, write(_, _)).WillByDefault([](const uint8_t*, int size) { return size; });
+    EXPECT_CALL(*mirrorSink, closeSegment(IsInitSegment()));
+    EXPECT_CALL(*mirrorSink, closeSegment(Not(IsInitSegment()))).WillOnce(Throw(MuxerException("Segment couldn't be stored")));
+
+    auto container = createContainer("mpegts", sink);
+    container->addMirrorOutput("matroska", mirrorSink, options);
+    ASSERT_TRUE(writeHeader(*container));
+    for(int frame = 0; frame < GOP_SIZE; ++frame)
+        container->muxFramePacket(makeFramePacket(*container, frame));
+
+    //Mirror closes its first segment on next keyframe and fails
+    auto packet = makeFramePacket(*container, GOP_SIZE);
+    auto buffer = av_buffer_ref(packet.buf);
+    ASSERT_THROW(container->muxFramePacket(std::move(packet)), MuxerException);
+    ASSERT_EQ(av_buffer_get_ref_count(buffer), 1);
+    av_buffer_unref(&buffer);
+}
+}
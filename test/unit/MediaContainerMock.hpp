@@ -14,9 +14,15 @@ class MediaContainerMock : public MediaContainerWrapper
 
         MOCK_METHOD(WrappedMediaStreamSharedPtr, createStream, (), (override));
         MOCK_METHOD(WrappedMediaStreamSharedPtr, createStream, (AVRational framerate), (override));
+        MOCK_METHOD(void, addMirrorOutput, (const char* formatName, OutputSinkSharedPtr sink, const ContainerOptions& options), (override));
+        MOCK_METHOD(void, setOptions, (const ContainerOptions& options), (override));
         MOCK_METHOD(bool, muxFramePacket, (AVPacket&& packet), (override));
+        MOCK_METHOD(bool, cutSegment, (), (override));
+        MOCK_METHOD(bool, finish, (), (override));
         MOCK_METHOD(int64_t, getMaxInterleaveDelta, (), (const, override));
         MOCK_METHOD(ByteVector, getMuxedData, (), (override));
+        MOCK_METHOD(size_t, readMuxedData, (uint8_t* dst, size_t capacity), (override));
+        MOCK_METHOD(size_t, getMuxedDataSize, (), (const, override));
         MOCK_METHOD(bool, boolOp, (), (const));
 };
 }
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <numeric>
+#include <gtest/gtest.h>
+#include "MediaDataQueue.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr auto DATA_SIZE = 2 * MediaDataQueue::CHUNK_SIZE + 321;
+
+ByteVector makeSequence(size_t size)
+{
+    ByteVector data(size);
+    std::iota(data.begin(), data.end(), 0);
+    return data;
+}
+
+ByteVector readAll(MediaDataQueue& queue, size_t readStep = 4096)
+{
+    ByteVector output(queue.unreadSize());
+    size_t readSize = 0;
+    while(auto result = queue.read(output.data() + readSize, std::min(readStep, output.size() - readSize)))
+        readSize += result;
+    output.resize(readSize);
+    return output;
+}
+}
+
+TEST(MediaDataQueueTest, QueueShouldReturnAppendedDataInOrder)
+{
+    MediaDataQueue queue;
+    auto input = makeSequence(DATA_SIZE);
+    queue.append({input.data(), 100});
+    queue.append({input.data() + 100, input.size() - 100});
+    ASSERT_EQ(queue.size(), input.size());
+    ASSERT_EQ(readAll(queue), input);
+    ASSERT_EQ(queue.unreadSize(), 0);
+}
+
+TEST(MediaDataQueueTest, QueueShouldKeepReadDataUntilItIsDiscarded)
+{
+    MediaDataQueue queue;
+    auto input = makeSequence(DATA_SIZE);
+    queue.append({input.data(), input.size()});
+
+    ByteVector output(MediaDataQueue::CHUNK_SIZE + 10);
+    ASSERT_EQ(queue.read(output.data(), output.size()), output.size());
+    queue.rewind();
+    ASSERT_EQ(queue.unreadSize(), input.size());
+    ASSERT_EQ(readAll(queue), input);
+
+    queue.rewind();
+    ASSERT_EQ(queue.read(output.data(), output.size()), output.size());
+    queue.discardReadData();
+    ASSERT_EQ(queue.size(), input.size() - output.size());
+    queue.rewind();
+    ASSERT_EQ(readAll(queue), ByteVector(input.begin() + output.size(), input.end()));
+}
+
+TEST(MediaDataQueueTest, QueueShouldResumeReadingWhenDataIsAppendedAfterItWasDrained)
+{
+    MediaDataQueue queue;
+    auto input = makeSequence(DATA_SIZE);
+    queue.append({input.data(), MediaDataQueue::CHUNK_SIZE});
+    ASSERT_EQ(readAll(queue).size(), MediaDataQueue::CHUNK_SIZE);
+    queue.discardReadData();
+    ASSERT_TRUE(queue.empty());
+
+    queue.append({input.data() + MediaDataQueue::CHUNK_SIZE, input.size() - MediaDataQueue::CHUNK_SIZE});
+    ASSERT_EQ(readAll(queue), ByteVector(input.begin() + MediaDataQueue::CHUNK_SIZE, input.end()));
+}
+
+TEST(MediaDataQueueTest, QueueShouldReadAttachedBuffersInOrderAndReleaseThemOnceDiscarded)
+{
+    MediaDataQueue queue;
+    auto input = makeSequence(DATA_SIZE);
+    auto releasedCount = 0;
+    auto release = [&releasedCount] { ++releasedCount; };
+    queue.append({input.data(), 100});
+    queue.attach({input.data() + 100, 200, release});
+    queue.append({input.data() + 300, 100});
+    queue.attach({input.data() + 400, input.size() - 400, release});
+    ASSERT_EQ(queue.size(), input.size());
+
+    ByteVector output(300);
+    ASSERT_EQ(queue.read(output.data(), output.size()), output.size());
+    queue.discardReadData();
+    ASSERT_EQ(releasedCount, 1);
+
+    queue.rewind();
+    ASSERT_EQ(readAll(queue), ByteVector(input.begin() + output.size(), input.end()));
+    queue.discardReadData();
+    ASSERT_EQ(releasedCount, 2);
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST(MediaDataQueueTest, QueueShouldSeekOnlyWithinDataThatWasNotDiscarded)
+{
+    MediaDataQueue queue;
+    auto input = makeSequence(DATA_SIZE);
+    queue.append({input.data(), input.size()});
+
+    ByteVector output(MediaDataQueue::CHUNK_SIZE + 10);
+    ASSERT_EQ(queue.read(output.data(), output.size()), output.size());
+    queue.discardUntil(100);
+    ASSERT_EQ(queue.getStartPosition(), 100);
+    ASSERT_EQ(queue.getReadPosition(), output.size());
+
+    ASSERT_FALSE(queue.seek(99));
+    ASSERT_FALSE(queue.seek(input.size() + 1));
+    ASSERT_TRUE(queue.seek(MediaDataQueue::CHUNK_SIZE));
+    ASSERT_EQ(queue.getReadPosition(), MediaDataQueue::CHUNK_SIZE);
+    ASSERT_EQ(readAll(queue), ByteVector(input.begin() + MediaDataQueue::CHUNK_SIZE, input.end()));
+
+    ASSERT_TRUE(queue.seek(100));
+    ASSERT_EQ(readAll(queue), ByteVector(input.begin() + 100, input.end()));
+}
+
+TEST(MediaDataQueueTest, QueueShouldSpillDataOverThresholdToFileAndReadItBackInOrder)
+{
+    MediaDataQueue queue;
+    queue.setSpilling(MediaDataQueue::CHUNK_SIZE);
+    auto input = makeSequence(SpillFile::WINDOW_SIZE + DATA_SIZE);
+    for(size_t appended = 0; appended < input.size(); appended += MediaDataQueue::CHUNK_SIZE / 3)
+    {
+        auto size = std::min(MediaDataQueue::CHUNK_SIZE / 3, input.size() - appended);
+        queue.append({input.data() + appended, size});
+    }
+    ASSERT_EQ(queue.size(), input.size());
+
+    ByteVector output(MediaDataQueue::CHUNK_SIZE + 10);
+    ASSERT_EQ(queue.read(output.data(), output.size()), output.size());
+    queue.discardReadData();
+    ASSERT_TRUE(queue.seek(SpillFile::WINDOW_SIZE));
+    queue.rewind();
+    ASSERT_EQ(readAll(queue), ByteVector(input.begin() + output.size(), input.end()));
+
+    //Once spilled data is consumed, new data is kept in memory again
+    queue.discardReadData();
+    queue.append({input.data(), 100});
+    ASSERT_EQ(readAll(queue), ByteVector(input.begin(), input.begin() + 100));
+}
+
+TEST(MediaDataQueueTest, QueueShouldKeepDataInMemoryWhenItCantBeSpilled)
+{
+    MediaDataQueue queue;
+    queue.setSpilling(MediaDataQueue::CHUNK_SIZE, "/nonexistent-spill-directory");
+    auto input = makeSequence(DATA_SIZE);
+    queue.append({input.data(), input.size()});
+    ASSERT_EQ(readAll(queue), input);
+}
+}
@@ -0,0 +1,160 @@
+#include <vector>
+#include <gtest/gtest.h>
+#include "MediaContainerContext.hpp"
+#include "SyntheticStreams.hpp"
+#include "utils.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr unsigned   FRAMES_COUNT = 120;
+//Far enough for probing to succeed with data before it
+constexpr unsigned   SPLIT_FRAME = 95;
+constexpr AVRational FRAMERATE = {30, 1};
+constexpr AVRational PREFRAMED_VIDEO_TIMEBASE = {1, 1000};
+constexpr int        AUDIO_SAMPLE_RATE = 48000;
+
+std::vector<ByteVector> takeFrames(MediaStreamContext& stream)
+{
+    std::vector<ByteVector> frames;
+    for(auto packet = stream.getNextFrame(); isPacketValid(packet); packet = stream.getNextFrame())
+    {
+        frames.emplace_back(packet.data, packet.data + packet.size);
+        av_packet_unref(&packet);
+    }
+    return frames;
+}
+}
+
+TEST(MediaStreamContextTest, FrameSplitBetweenInputsShouldBeDemuxedIntact)
+{
+    if(av_find_input_format("h264") == nullptr)
+        GTEST_SKIP() << "FFmpeg is built without H.264 demuxer";
+
+    auto accessUnits = Synthetic::generateH264AccessUnits(FRAMES_COUNT);
+    auto& splitFrame = accessUnits[SPLIT_FRAME];
+    auto splitPoint = splitFrame.size() / 2;
+    ByteVector firstPart = Synthetic::concatenate({ accessUnits.begin(), accessUnits.begin() + SPLIT_FRAME });
+    firstPart.insert(firstPart.end(), splitFrame.begin(), splitFrame.begin() + splitPoint);
+    ByteVector secondPart(splitFrame.begin() + splitPoint, splitFrame.end());
+    auto rest = Synthetic::concatenate({ accessUnits.begin() + SPLIT_FRAME + 1, accessUnits.end() });
+    secondPart.insert(secondPart.end(), rest.begin(), rest.end());
+
+    MediaContainerContext container("mp4");
+    auto stream = container.createStream(FRAMERATE);
+    stream->fillBuffer(ByteArray(firstPart.data(), firstPart.size()));
+    ASSERT_TRUE(stream->initializeFormat());
+    auto frames = takeFrames(*stream);
+    ASSERT_LT(frames.size(), SPLIT_FRAME + 1);
+
+    //Demuxer runs out of data in the middle of split frame, then gets the rest of it
+    stream->fillBuffer(ByteArray(secondPart.data(), secondPart.size()));
+    auto moreFrames = takeFrames(*stream);
+    frames.insert(frames.end(), moreFrames.begin(), moreFrames.end());
+
+    //Last frame stays in parser, as its end isn't known yet
+    ASSERT_EQ(frames.size(), FRAMES_COUNT - 1);
+    for(unsigned i = 0; i < frames.size(); ++i)
+        ASSERT_EQ(frames[i], accessUnits[i]) << "Frame " << i << " differs";
+}
+
+TEST(MediaStreamContextTest, LastFrameShouldBeDemuxedOnceInputIsFinished)
+{
+    if(av_find_input_format("h264") == nullptr)
+        GTEST_SKIP() << "FFmpeg is built without H.264 demuxer";
+
+    auto accessUnits = Synthetic::generateH264AccessUnits(FRAMES_COUNT);
+    auto input = Synthetic::concatenate(accessUnits);
+    MediaContainerContext container("mp4");
+    auto stream = container.createStream(FRAMERATE);
+    stream->fillBuffer(ByteArray(input.data(), input.size()));
+    ASSERT_EQ(takeFrames(*stream).size(), FRAMES_COUNT - 1);
+
+    stream->finishInput();
+    auto frames = takeFrames(*stream);
+    ASSERT_EQ(frames.size(), 1);
+    ASSERT_EQ(frames.front(), accessUnits.back());
+}
+
+TEST(MediaStreamContextTest, ProbingShouldBeRetriedEachTimeBufferedDataDoubles)
+{
+    //Attempts after 4, 8, 16, ..., 512 KiB and 1 MiB - total probed data stays below twice the buffered size
+    constexpr size_t INPUT_PIECE_SIZE = 4 * 1024;
+    constexpr size_t INPUT_SIZE = 1024 * 1024;
+    constexpr unsigned EXPECTED_ATTEMPTS = 9;
+
+    //Zeros can't be identified as any format, so every attempt fails
+    ByteVector inputPiece(INPUT_PIECE_SIZE, 0);
+    MediaContainerContext container("mp4");
+    auto stream = container.createStream({0, 0});
+    for(size_t bufferedSize = 0; bufferedSize < INPUT_SIZE; bufferedSize += inputPiece.size())
+    {
+        stream->fillBuffer(ByteArray(inputPiece.data(), inputPiece.size()));
+        ASSERT_FALSE(stream->initializeFormat());
+    }
+
+    ASSERT_EQ(stream->getProbeAttemptsCount(), EXPECTED_ATTEMPTS);
+}
+
+TEST(MediaStreamContextTest, PreframedPacketsShouldBeMuxedWithTheirTimingAndKeyframeFlags)
+{
+    constexpr unsigned PACKETS_COUNT = 45;
+    Synthetic::SyntheticVideoSettings videoSettings;
+    auto accessUnits = Synthetic::generateH264AccessUnits(PACKETS_COUNT, videoSettings);
+    auto audioFrames = Synthetic::generateAdtsFrames(PACKETS_COUNT, Synthetic::SyntheticAudioSettings { .sampleRate = AUDIO_SAMPLE_RATE });
+
+    MediaContainerContext container("mpegts");
+    auto video = container.createStream(FRAMERATE);
+    auto audio = container.createStream({0, 0});
+    video->setCodecParameters(CodecParameters { AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_H264, PREFRAMED_VIDEO_TIMEBASE, {},
+                                                videoSettings.width, videoSettings.height });
+    audio->setCodecParameters(CodecParameters { AVMEDIA_TYPE_AUDIO, AV_CODEC_ID_AAC, {1, AUDIO_SAMPLE_RATE}, {}, 0, 0,
+                                                AUDIO_SAMPLE_RATE, 2, Synthetic::AAC_SAMPLES_PER_FRAME });
+
+    //Neither durations nor video's decoding timestamps are given, so they're derived from framerate, frame size and pts
+    auto videoFrameDuration = av_rescale_q(1, av_inv_q(FRAMERATE), PREFRAMED_VIDEO_TIMEBASE);
+    for(unsigned i = 0; i < PACKETS_COUNT; ++i)
+    {
+        auto& accessUnit = accessUnits[i];
+        auto& audioFrame = audioFrames[i];
+        video->queuePacket(EncodedPacket { {accessUnit.data(), accessUnit.size()}, i * videoFrameDuration, AV_NOPTS_VALUE, 0,
+                                           i % videoSettings.gopSize == 0 });
+        audio->queuePacket(EncodedPacket { {audioFrame.data(), audioFrame.size()}, i * Synthetic::AAC_SAMPLES_PER_FRAME,
+                                           i * Synthetic::AAC_SAMPLES_PER_FRAME, 0, true });
+    }
+
+    bool isHeaderWritten = container;
+    ASSERT_TRUE(isHeaderWritten);
+
+    //Muxer picks its own time bases when header is written, packets are rescaled to them
+    auto videoTimebase = video->getStream()->time_base;
+    auto audioTimebase = audio->getStream()->time_base;
+    for(unsigned i = 0; i < PACKETS_COUNT; ++i)
+    {
+        auto videoPacket = video->getNextFrame();
+        ASSERT_TRUE(isPacketValid(videoPacket));
+        EXPECT_EQ(videoPacket.stream_index, video->getStream()->index);
+        EXPECT_EQ(videoPacket.size, int(accessUnits[i].size()));
+        EXPECT_EQ(videoPacket.pts, av_rescale_q(i * videoFrameDuration, PREFRAMED_VIDEO_TIMEBASE, videoTimebase)) << "Frame " << i;
+        EXPECT_EQ(videoPacket.dts, videoPacket.pts) << "Frame " << i;
+        EXPECT_EQ(videoPacket.duration, av_rescale_q(videoFrameDuration, PREFRAMED_VIDEO_TIMEBASE, videoTimebase)) << "Frame " << i;
+        EXPECT_EQ(bool(videoPacket.flags & AV_PKT_FLAG_KEY), i % videoSettings.gopSize == 0) << "Frame " << i;
+        container.muxFramePacket(std::move(videoPacket));
+
+        auto audioPacket = audio->getNextFrame();
+        ASSERT_TRUE(isPacketValid(audioPacket));
+        EXPECT_EQ(audioPacket.stream_index, audio->getStream()->index);
+        EXPECT_EQ(audioPacket.pts, av_rescale_q(i * Synthetic::AAC_SAMPLES_PER_FRAME, {1, AUDIO_SAMPLE_RATE}, audioTimebase)) << "Frame " << i;
+        EXPECT_EQ(audioPacket.duration, av_rescale_q(Synthetic::AAC_SAMPLES_PER_FRAME, {1, AUDIO_SAMPLE_RATE}, audioTimebase)) << "Frame " << i;
+        container.muxFramePacket(std::move(audioPacket));
+    }
+
+    ASSERT_FALSE(isPacketValid(video->getNextFrame()));
+    ASSERT_EQ(video->getBufferedDataSize(), 0);
+    ASSERT_EQ(audio->getBufferedDataSize(), 0);
+    ASSERT_GT(container.getMuxedDataSize(), 0);
+}
+}
@@ -15,9 +15,16 @@ class MediaStreamMock : public MediaStreamWrapper
         operator bool() { return boolOp(); }
 
         MOCK_METHOD(void, fillBuffer, (const ByteArray& data), (const, override));
+        MOCK_METHOD(void, attachBuffer, (const SharedByteArray& data), (const, override));
+        MOCK_METHOD(void, queuePacket, (const EncodedPacket& packet), (override));
+        MOCK_METHOD(void, setCodecParameters, (const CodecParameters& params), (override));
+        MOCK_METHOD(void, setProbeHints, (const StreamProbeHints& hints), (override));
+        MOCK_METHOD(void, finishInput, (), (override));
         MOCK_METHOD(AVPacket, getNextFrame, (), (override));
         MOCK_METHOD(bool, hasQueuedData, (), (const, override));
         MOCK_METHOD(size_t, getBufferedDataSize, (), (const, override));
+        MOCK_METHOD(void, setMaxPooledBufferSize, (size_t maxPooledSize), (override));
+        MOCK_METHOD(void, setBufferSpilling, (size_t thresholdSize, const std::string& directory), (override));
         MOCK_METHOD(AVRational, getTimeBase, (), (const, override));
         MOCK_METHOD(bool, boolOp, (), (const));
 };
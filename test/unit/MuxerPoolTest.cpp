@@ -0,0 +1,151 @@
+#include <atomic>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "MuxerPool.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr auto WORKERS_COUNT           = 4;
+constexpr auto SESSIONS_COUNT          = 64;
+constexpr auto SCHEDULES_PER_SESSION   = 1000;
+constexpr auto AFFINITY_ROUNDS_COUNT   = 16;
+
+class CountingSession : public PoolSession
+{
+    public:
+        std::atomic<int>  pendingWork = 0;
+        std::atomic<int>  doneWork = 0;
+        std::atomic<bool> isRunning = false;
+        std::atomic<bool> wasRunConcurrently = false;
+
+        void addWork()
+        {
+            pendingWork.fetch_add(1);
+            schedule();
+        }
+
+    protected:
+        void process() override
+        {
+            if(isRunning.exchange(true))
+                wasRunConcurrently = true;
+
+            doneWork += pendingWork.exchange(0);
+            isRunning = false;
+        }
+};
+
+class ThreadRecordingSession : public PoolSession
+{
+    public:
+        std::atomic<int>          processCount = 0;
+        std::set<std::thread::id> threads;
+
+    protected:
+        void process() override
+        {
+            threads.insert(std::this_thread::get_id());
+            ++processCount;
+        }
+};
+
+class FailingSession : public PoolSession
+{
+    public:
+        std::atomic<int> processCount = 0;
+
+    protected:
+        void process() override
+        {
+            ++processCount;
+            throw std::runtime_error("failure");
+        }
+};
+}
+
+TEST(MuxerPoolTest, AllScheduledWorkShouldBeDoneWithoutProcessingSessionConcurrently)
+{
+    std::vector<std::shared_ptr<CountingSession>> sessions;
+    {
+        MuxerPool pool(WORKERS_COUNT);
+        for(int i = 0; i < SESSIONS_COUNT; ++i)
+            sessions.push_back(pool.createSession<CountingSession>());
+
+        std::vector<std::thread> producers;
+        for(int p = 0; p < 2; ++p)
+        {
+            producers.emplace_back([&sessions]
+            {
+                for(int i = 0; i < SCHEDULES_PER_SESSION; ++i)
+                    for(auto& session : sessions)
+                        session->addWork();
+            });
+        }
+
+        for(auto& producer : producers)
+            producer.join();
+    }
+
+    for(auto& session : sessions)
+    {
+        ASSERT_EQ(session->doneWork, 2 * SCHEDULES_PER_SESSION);
+        ASSERT_FALSE(session->wasRunConcurrently);
+        ASSERT_EQ(session->getError(), nullptr);
+    }
+}
+
+TEST(MuxerPoolTest, SessionScheduledWhileItsHomeWorkerIsIdleShouldBeProcessedByThatWorker)
+{
+    MuxerPool pool(WORKERS_COUNT);
+    std::vector<std::shared_ptr<ThreadRecordingSession>> sessions;
+    for(int i = 0; i < WORKERS_COUNT; ++i)
+        sessions.push_back(pool.createSession<ThreadRecordingSession>());
+
+    for(int round = 1; round <= AFFINITY_ROUNDS_COUNT; ++round)
+    {
+        for(auto& session : sessions)
+        {
+            //Workers go to sleep once they find nothing to do
+            while(pool.getIdleWorkersCount() < unsigned(WORKERS_COUNT))
+                std::this_thread::yield();
+            session->schedule();
+            while(session->processCount < round)
+                std::this_thread::yield();
+        }
+    }
+
+    //Every session has different home worker
+    std::set<std::thread::id> allThreads;
+    for(auto& session : sessions)
+    {
+        ASSERT_EQ(session->threads.size(), 1u);
+        allThreads.insert(*session->threads.begin());
+    }
+    ASSERT_EQ(allThreads.size(), size_t(WORKERS_COUNT));
+}
+
+TEST(MuxerPoolTest, FailedSessionShouldNotBeProcessedAgain)
+{
+    auto session = std::make_shared<FailingSession>();
+    {
+        MuxerPool pool(WORKERS_COUNT);
+        pool.addSession(session);
+        session->schedule();
+        while(!session->getError())
+            std::this_thread::yield();
+
+        session->schedule();
+    }
+
+    ASSERT_EQ(session->processCount, 1);
+    ASSERT_NE(session->getError(), nullptr);
+}
+}
@@ -1,8 +1,10 @@
 #include <array>
+#include <chrono>
 #include <gtest/gtest.h>
 #include "Muxer.hpp"
 #include "MediaStreamMock.hpp"
 #include "MediaContainerMock.hpp"
+#include "MuxerException.hpp"
 
 using namespace testing;
 
@@ -41,6 +43,20 @@ class MuxerTest : public Muxer<StreamsCount>
             for(auto& currentStream : this->streams)
                 currentStream = *(currentMock++);
         }
+
+        void advanceTime(std::chrono::milliseconds duration)
+        {
+            currentTime += duration;
+        }
+
+    protected:
+        std::chrono::steady_clock::time_point getCurrentTime() const override
+        {
+            return currentTime;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
 };
 
 template <typename T>
@@ -285,4 +301,122 @@ TYPED_TEST(MuxerTestFixture, MuxerShouldReturnMuxedDataWhileFlushingOnlyWhenData
     data = muxer.getMuxedData();
     ASSERT_TRUE(data.empty());
 }
+
+TYPED_TEST(MuxerTestFixture, MuxerShouldReportMuxedDataAvailabilityAccordingToDataLeftAfterReadingIntoBuffer)
+{
+    ByteVector output(this->outputData.size() / 2);
+
+    EXPECT_CALL(this->onContainerCtxtMock(), readMuxedData(output.data(), output.size())).Times(2).WillRepeatedly(Return(output.size()));
+    EXPECT_CALL(this->onContainerCtxtMock(), getMuxedDataSize()).WillOnce(Return(output.size())).WillOnce(Return(0));
+
+    auto muxer = this->createMuxer();
+    ASSERT_EQ(muxer.readMuxedData(output), output.size());
+    ASSERT_TRUE(muxer.hasMuxedData());
+
+    ASSERT_EQ(muxer.readMuxedData(output), output.size());
+    ASSERT_FALSE(muxer.hasMuxedData());
+}
+
+TYPED_TEST(MuxerTestFixture, MuxerShouldMuxPreframedPacketsWithoutDemuxingThem)
+{
+    this->expectCountlessBooleanCastForAllStreamsReturning(true);
+
+    this->expectCountlessGetTimeBaseReturningFps();
+
+    EXPECT_CALL(this->template onStreamCtxtMock<0>(), queuePacket(_)).Times(2);
+    EXPECT_CALL(this->template onStreamCtxtMock<0>(), getNextFrame()).WillOnce(Return(AVPacket {.size = 1, .duration = 1}))
+                                                                     .WillOnce(Return(AVPacket {.size = 0}))
+                                                                     .WillOnce(Return(AVPacket {.size = 1, .duration = 1}))
+                                                                     .WillOnce(Return(AVPacket {.size = 0}));
+
+    EXPECT_CALL(this->onContainerCtxtMock(), boolOp()).WillRepeatedly(Return(true));
+
+    EXPECT_CALL(this->onContainerCtxtMock(), muxFramePacket(_)).WillOnce(Return(false)).WillOnce(Return(true));
+
+    EXPECT_CALL(this->onContainerCtxtMock(), getMaxInterleaveDelta()).WillRepeatedly(Return(100ULL*AV_TIME_BASE));
+
+    auto muxer = this->createMuxer();
+    ASSERT_FALSE(muxer.template muxPacket<0>(this->inputData.data(), this->inputData.size(), 0, 0, true));
+    ASSERT_TRUE(muxer.template muxPacket<0>(this->inputData.data(), this->inputData.size(), 1, 1, false));
+}
+
+TYPED_TEST(MuxerTestFixture, FinishedStreamShouldNotHoldOtherStreamsBackOnceItIsDrained)
+{
+    //Only muxer with exactly two streams is set up so that one of them ends first
+    if constexpr(TestFixture::STREAMS_COUNT == 2)
+    {
+        this->expectCountlessFillBufferForAllStreams();
+
+        this->expectCountlessBooleanCastForAllStreamsReturning(true);
+
+        this->expectCountlessGetTimeBaseReturningFps();
+
+        EXPECT_CALL(this->template onStreamCtxtMock<0>(), finishInput());
+        EXPECT_CALL(this->template onStreamCtxtMock<0>(), getNextFrame()).WillOnce(Return(AVPacket {.size = 1, .duration = 1}))
+                                                                         .WillRepeatedly(Return(AVPacket {.size = 0}));
+        EXPECT_CALL(this->template onStreamCtxtMock<1>(), getNextFrame()).WillOnce(Return(AVPacket {.size = 1, .duration = FPS}))
+                                                                         .WillOnce(Return(AVPacket {.size = 1, .duration = FPS}))
+                                                                         .WillRepeatedly(Return(AVPacket {.size = 0}));
+
+        EXPECT_CALL(this->onContainerCtxtMock(), boolOp()).WillRepeatedly(Return(true));
+
+        EXPECT_CALL(this->onContainerCtxtMock(), muxFramePacket(_)).Times(3).WillRepeatedly(Return(false));
+
+        EXPECT_CALL(this->onContainerCtxtMock(), getMaxInterleaveDelta()).WillRepeatedly(Return(AV_TIME_BASE));
+
+        //Second stream gets a second ahead and is held back, until the first one ends
+        auto muxer = this->createMuxer();
+        muxer.template muxMediaData<1>(this->inputData);
+        muxer.template finishInput<0>();
+        muxer.flush();
+
+        ASSERT_THROW(muxer.template muxMediaData<0>(this->inputData), MuxerException);
+    }
+}
+
+TYPED_TEST(MuxerTestFixture, StalledStreamShouldBeLeftOutOfInterleavingUntilItReceivesDataAgain)
+{
+    //Only muxer with exactly two streams is set up so that one of them stalls
+    if constexpr(TestFixture::STREAMS_COUNT == 2)
+    {
+        constexpr auto STARVATION_TIMEOUT = std::chrono::milliseconds(50);
+        this->expectCountlessFillBufferForAllStreams();
+
+        this->expectCountlessBooleanCastForAllStreamsReturning(true);
+
+        this->expectCountlessGetTimeBaseReturningFps();
+
+        EXPECT_CALL(this->template onStreamCtxtMock<0>(), getBufferedDataSize()).WillRepeatedly(Return(0));
+        EXPECT_CALL(this->template onStreamCtxtMock<1>(), getBufferedDataSize()).WillRepeatedly(Return(0));
+        EXPECT_CALL(this->template onStreamCtxtMock<0>(), getNextFrame()).WillRepeatedly(Return(AVPacket {.size = 1, .duration = FPS}));
+
+        EXPECT_CALL(this->onContainerCtxtMock(), boolOp()).WillRepeatedly(Return(true));
+
+        EXPECT_CALL(this->onContainerCtxtMock(), muxFramePacket(_)).Times(4).WillRepeatedly(Return(false));
+
+        EXPECT_CALL(this->onContainerCtxtMock(), getMaxInterleaveDelta()).WillRepeatedly(Return(2 * AV_TIME_BASE));
+
+        //First stream gets two seconds ahead and is held back by the second one, which doesn't receive anything
+        auto muxer = this->createMuxer();
+        muxer.setStarvationTimeout(STARVATION_TIMEOUT);
+        muxer.template muxMediaData<0>(this->inputData);
+        ASSERT_EQ(muxer.getMetrics().streams[0].limitedCount, 1);
+        ASSERT_EQ(muxer.getMetrics().streams[1].stalledCount, 0);
+
+        //Once timeout passes, second stream is left out and first one is no longer held back
+        muxer.advanceTime(2 * STARVATION_TIMEOUT);
+        EXPECT_CALL(this->template onStreamCtxtMock<0>(), getNextFrame()).WillOnce(Return(AVPacket {.size = 1, .duration = FPS}))
+                                                                         .WillOnce(Return(AVPacket {.size = 1, .duration = FPS}))
+                                                                         .WillOnce(Return(AVPacket {.size = 0}));
+        muxer.template muxMediaData<0>(this->inputData);
+        auto metrics = muxer.getMetrics();
+        ASSERT_EQ(metrics.streams[1].stalledCount, 1);
+        ASSERT_EQ(metrics.packetsMuxed, 4);
+
+        //Stream which receives data again rejoins along with the slowest active stream
+        EXPECT_CALL(this->template onStreamCtxtMock<1>(), getNextFrame()).WillOnce(Return(AVPacket {.size = 0}));
+        muxer.template muxMediaData<1>(this->inputData);
+        ASSERT_EQ(muxer.getMetrics().streams[1].relativeTimeAhead, muxer.getMetrics().streams[0].relativeTimeAhead);
+    }
+}
 }
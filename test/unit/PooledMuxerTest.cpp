@@ -0,0 +1,213 @@
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+#include "PooledMuxer.hpp"
+#include "MediaStreamMock.hpp"
+#include "MediaContainerMock.hpp"
+#include "MuxerException.hpp"
+#include "utils.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr auto FPS                  = 24;
+constexpr auto WORKERS_COUNT        = 2;
+constexpr auto BUFFERS_COUNT        = 16;
+constexpr auto MAX_INTERLEAVE_DELTA = 2 * AV_TIME_BASE;
+constexpr auto PROCESSING_TIMEOUT   = std::chrono::seconds(5);
+
+class LoggerMock : public ILogger
+{
+    public:
+        MOCK_METHOD(void, logAVMuxerMessage, (const std::string& msg, LogLevel level), (override));
+};
+}
+
+class PooledMuxerTest : public PooledMuxer<1>
+{
+    public:
+        PooledMuxerTest(std::shared_ptr<MediaContainerWrapper> containerCtxtMock, WrappedMediaStreamSharedPtr streamCtxtMock)
+            : PooledMuxer<1>("mp4", AVRational {FPS, 1}, std::make_shared<CallbackSink>([](const ByteArray&) { return true; }))
+        {
+            containerCtxt = containerCtxtMock;
+            streams[0] = streamCtxtMock;
+        }
+};
+
+class PooledMuxerTestFixture : public Test
+{
+    public:
+        PooledMuxerTestFixture()
+            : containerCtxtMock(std::make_shared<StrictMock<MediaContainerMock>>("mp4")),
+              streamCtxtMock(std::make_shared<StrictMock<MediaStreamMock>>())
+        {
+            //Every pushed buffer holds exactly one frame
+            EXPECT_CALL(*streamCtxtMock, boolOp()).WillRepeatedly(Return(true));
+            EXPECT_CALL(*streamCtxtMock, attachBuffer(_)).WillRepeatedly([this](const SharedByteArray&) { ++pendingFrames; });
+            EXPECT_CALL(*streamCtxtMock, fillBuffer(_)).Times(AnyNumber());
+            EXPECT_CALL(*streamCtxtMock, getNextFrame()).WillRepeatedly([this]
+            {
+                return pendingFrames.exchange(0) > 0 ? AVPacket {.size = 1, .duration = 1} : AVPacket {.size = 0};
+            });
+            EXPECT_CALL(*streamCtxtMock, getTimeBase()).WillRepeatedly(Return(AVRational {1, FPS}));
+            EXPECT_CALL(*containerCtxtMock, boolOp()).WillRepeatedly(Return(true));
+            EXPECT_CALL(*containerCtxtMock, getMaxInterleaveDelta()).WillRepeatedly(Return(MAX_INTERLEAVE_DELTA));
+        }
+
+    protected:
+        std::shared_ptr<StrictMock<MediaContainerMock>> containerCtxtMock;
+        std::shared_ptr<StrictMock<MediaStreamMock>>    streamCtxtMock;
+        std::atomic<int>                                pendingFrames = 0;
+        const ByteVector                                inputData = {0, 1, 2, 3};
+};
+
+TEST(PooledMuxerTest, MuxerShouldNotBeCreatedWithoutSink)
+{
+    MuxerPool pool(WORKERS_COUNT);
+    ASSERT_THROW(pool.createSession<PooledMuxer<1>>("mp4", AVRational {FPS, 1}, nullptr), std::invalid_argument);
+}
+
+TEST_F(PooledMuxerTestFixture, PushedDataShouldBeMuxedByPoolWorker)
+{
+    std::atomic<int> packetsCount = 0;
+    std::atomic<bool> isMuxedOnCallerThread = false;
+    auto callerThread = std::this_thread::get_id();
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillRepeatedly([&](AVPacket&&)
+    {
+        isMuxedOnCallerThread = isMuxedOnCallerThread || std::this_thread::get_id() == callerThread;
+        ++packetsCount;
+        return false;
+    });
+
+    MuxerPool pool(WORKERS_COUNT);
+    auto muxer = pool.createSession<PooledMuxerTest>(containerCtxtMock, streamCtxtMock);
+    for(int i = 0; i < BUFFERS_COUNT; ++i)
+        ASSERT_TRUE(muxer->pushMediaData<0>(inputData));
+    muxer->requestFlush();
+
+    auto deadline = std::chrono::steady_clock::now() + PROCESSING_TIMEOUT;
+    while(packetsCount < BUFFERS_COUNT && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+
+    ASSERT_EQ(packetsCount, BUFFERS_COUNT);
+    ASSERT_FALSE(isMuxedOnCallerThread);
+    ASSERT_EQ(muxer->getError(), nullptr);
+}
+
+TEST_F(PooledMuxerTestFixture, FailedSessionShouldStopAcceptingInput)
+{
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillOnce(Throw(MuxerException("Couldn't mux media data")));
+
+    MuxerPool pool(WORKERS_COUNT);
+    auto muxer = pool.createSession<PooledMuxerTest>(containerCtxtMock, streamCtxtMock);
+    ASSERT_TRUE(muxer->pushMediaData<0>(inputData));
+
+    auto deadline = std::chrono::steady_clock::now() + PROCESSING_TIMEOUT;
+    while(!muxer->getError() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+
+    ASSERT_NE(muxer->getError(), nullptr);
+    ASSERT_FALSE(muxer->pushMediaData<0>(inputData));
+    ASSERT_FALSE(muxer->finishInput<0>());
+}
+
+TEST_F(PooledMuxerTestFixture, SegmentShouldBeCutByPoolWorkerAfterPushedDataIsMuxed)
+{
+    std::atomic<int> packetsCount = 0;
+    std::atomic<int> packetsCountWhenCut = -1;
+    EXPECT_CALL(*streamCtxtMock, finishInput());
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillRepeatedly([&packetsCount](AVPacket&&)
+    {
+        ++packetsCount;
+        return false;
+    });
+    EXPECT_CALL(*containerCtxtMock, cutSegment()).WillOnce([&]
+    {
+        packetsCountWhenCut = packetsCount.load();
+        return true;
+    });
+
+    MuxerPool pool(WORKERS_COUNT);
+    auto muxer = pool.createSession<PooledMuxerTest>(containerCtxtMock, streamCtxtMock);
+    for(int i = 0; i < BUFFERS_COUNT; ++i)
+        ASSERT_TRUE(muxer->pushMediaData<0>(inputData));
+    ASSERT_TRUE(muxer->finishInput<0>());
+    muxer->requestSegmentCut();
+
+    auto deadline = std::chrono::steady_clock::now() + PROCESSING_TIMEOUT;
+    while(packetsCountWhenCut < 0 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+
+    ASSERT_EQ(packetsCountWhenCut, BUFFERS_COUNT);
+    ASSERT_EQ(muxer->getError(), nullptr);
+}
+
+TEST_F(PooledMuxerTestFixture, SessionShouldBeFinishedByPoolWorkerAfterPushedDataIsMuxed)
+{
+    std::atomic<int> packetsCount = 0;
+    std::atomic<int> packetsCountWhenFinished = -1;
+    EXPECT_CALL(*streamCtxtMock, finishInput());
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillRepeatedly([&packetsCount](AVPacket&&)
+    {
+        ++packetsCount;
+        return false;
+    });
+    EXPECT_CALL(*containerCtxtMock, finish()).WillOnce([&]
+    {
+        packetsCountWhenFinished = packetsCount.load();
+        return false;
+    });
+
+    MuxerPool pool(WORKERS_COUNT);
+    auto muxer = pool.createSession<PooledMuxerTest>(containerCtxtMock, streamCtxtMock);
+    for(int i = 0; i < BUFFERS_COUNT; ++i)
+        ASSERT_TRUE(muxer->pushMediaData<0>(inputData));
+    ASSERT_TRUE(muxer->finishInput<0>());
+    muxer->requestFinish();
+
+    auto deadline = std::chrono::steady_clock::now() + PROCESSING_TIMEOUT;
+    while(packetsCountWhenFinished < 0 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+
+    ASSERT_EQ(packetsCountWhenFinished, BUFFERS_COUNT);
+    ASSERT_EQ(muxer->getError(), nullptr);
+}
+
+TEST_F(PooledMuxerTestFixture, MuxerCreatedOutsideOfPoolShouldNotBeScheduled)
+{
+    auto muxer = std::make_shared<PooledMuxerTest>(containerCtxtMock, streamCtxtMock);
+    ASSERT_THROW(muxer->pushMediaData<0>(inputData), MuxerException);
+    ASSERT_THROW(muxer->requestFlush(), MuxerException);
+}
+
+TEST_F(PooledMuxerTestFixture, MuxerLoggerShouldGetMessagesLoggedByPoolWorker)
+{
+    auto logger = std::make_shared<StrictMock<LoggerMock>>();
+    std::atomic<bool> isLogged = false;
+    EXPECT_CALL(*containerCtxtMock, muxFramePacket(_)).WillOnce([](AVPacket&&)
+    {
+        log(LogLevel::WARNING, "packet muxed");
+        return false;
+    });
+    EXPECT_CALL(*logger, logAVMuxerMessage("packet muxed", LogLevel::WARNING)).WillOnce([&isLogged](const std::string&, LogLevel)
+    {
+        isLogged = true;
+    });
+
+    MuxerPool pool(WORKERS_COUNT);
+    auto muxer = pool.createSession<PooledMuxerTest>(containerCtxtMock, streamCtxtMock);
+    muxer->setLogger(logger);
+    ASSERT_TRUE(muxer->pushMediaData<0>(inputData));
+
+    auto deadline = std::chrono::steady_clock::now() + PROCESSING_TIMEOUT;
+    while(!isLogged && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+    ASSERT_TRUE(isLogged);
+}
+}
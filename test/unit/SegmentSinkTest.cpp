@@ -0,0 +1,90 @@
+#include <vector>
+#include <gtest/gtest.h>
+#include "OutputSink.hpp"
+#include "MuxerException.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr int64_t SEGMENT_DURATION = 2000000;
+}
+
+TEST(SegmentSinkTest, SinkShouldDeliverDataWrittenBetweenBoundariesAsSeparateSegments)
+{
+    std::vector<SegmentSink::Segment> segments;
+    SegmentSink sink([&segments](SegmentSink::Segment&& segment) { segments.push_back(std::move(segment)); });
+
+    const ByteVector initData = {0, 1, 2};
+    const ByteVector mediaData = {3, 4, 5, 6, 7};
+    ASSERT_EQ(sink.write(initData.data(), initData.size()), initData.size());
+    sink.closeSegment(SegmentInfo { .isInitSegment = true });
+    ASSERT_EQ(sink.write(mediaData.data(), 2), 2);
+    ASSERT_EQ(sink.write(mediaData.data() + 2, 3), 3);
+    sink.closeSegment(SegmentInfo { false, 1, 0, 0, SEGMENT_DURATION });
+    ASSERT_FALSE(sink.hasPendingData());
+
+    ASSERT_EQ(segments.size(), 2);
+    ASSERT_TRUE(segments[0].info.isInitSegment);
+    ASSERT_EQ(segments[0].data, initData);
+    ASSERT_FALSE(segments[1].info.isInitSegment);
+    ASSERT_EQ(segments[1].info.sequenceNumber, 1);
+    ASSERT_EQ(segments[1].info.duration, SEGMENT_DURATION);
+    ASSERT_EQ(segments[1].data, mediaData);
+}
+
+TEST(SegmentSinkTest, SinkShouldNotAcceptEmptyCallback)
+{
+    ASSERT_THROW(SegmentSink(nullptr), MuxerException);
+}
+
+TEST(SegmentSinkTest, SinkShouldPassChunksAsTheyAreCompleteAndThenWholeSegment)
+{
+    std::vector<ByteVector> chunks;
+    std::vector<SegmentSink::Segment> segments;
+    SegmentSink sink([&segments](SegmentSink::Segment&& segment) { segments.push_back(std::move(segment)); },
+                     [&chunks](const SegmentInfo&, const ByteArray& data) { chunks.emplace_back(data.begin(), data.end()); });
+
+    const ByteVector mediaData = {0, 1, 2, 3, 4, 5, 6, 7};
+    sink.write(mediaData.data(), 3);
+    sink.closeChunk(SegmentInfo { false, 1, 0 });
+    ASSERT_EQ(chunks.size(), 1);
+    ASSERT_TRUE(segments.empty());
+
+    sink.write(mediaData.data() + 3, 5);
+    sink.closeChunk(SegmentInfo { false, 1, 1 });
+    sink.closeSegment(SegmentInfo { false, 1 });
+
+    ASSERT_EQ(chunks.size(), 2);
+    ASSERT_EQ(chunks[0], ByteVector(mediaData.begin(), mediaData.begin() + 3));
+    ASSERT_EQ(chunks[1], ByteVector(mediaData.begin() + 3, mediaData.end()));
+    ASSERT_EQ(segments.size(), 1);
+    ASSERT_EQ(segments[0].data, mediaData);
+}
+
+TEST(SegmentSinkTest, DataWrittenRightBeforeSegmentIsClosedShouldEndItsLastChunkAndSegment)
+{
+    std::vector<ByteVector> chunks;
+    std::vector<SegmentSink::Segment> segments;
+    SegmentSink sink([&segments](SegmentSink::Segment&& segment) { segments.push_back(std::move(segment)); },
+                     [&chunks](const SegmentInfo&, const ByteArray& data) { chunks.emplace_back(data.begin(), data.end()); });
+
+    //As container's trailer is, when muxing is finished
+    const ByteVector mediaData = {0, 1, 2, 3};
+    const ByteVector trailer = {'m', 'f', 'r', 'a'};
+    sink.write(mediaData.data(), mediaData.size());
+    sink.write(trailer.data(), trailer.size());
+    sink.closeChunk(SegmentInfo { false, 1, 0 });
+    sink.closeSegment(SegmentInfo { false, 1 });
+    ASSERT_FALSE(sink.hasPendingData());
+
+    ASSERT_EQ(segments.size(), 1);
+    ASSERT_EQ(chunks.size(), 1);
+    ByteVector expectedData = mediaData;
+    expectedData.insert(expectedData.end(), trailer.begin(), trailer.end());
+    ASSERT_EQ(segments[0].data, expectedData);
+    ASSERT_EQ(chunks[0], expectedData);
+}
+}
@@ -0,0 +1,58 @@
+#include <thread>
+#include <gtest/gtest.h>
+#include "SpscQueue.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+constexpr auto ITEMS_COUNT = 100000;
+}
+
+TEST(SpscQueueTest, QueueShouldRejectItemsWhenFull)
+{
+    SpscQueue<int> queue(3);
+    ASSERT_EQ(queue.getCapacity(), 4);
+    for(int i = 0; i < 4; ++i)
+        ASSERT_TRUE(queue.tryPush(int(i)));
+
+    ASSERT_TRUE(queue.isFull());
+    ASSERT_FALSE(queue.tryPush(4));
+
+    int item;
+    ASSERT_TRUE(queue.tryPop(item));
+    ASSERT_EQ(item, 0);
+    ASSERT_TRUE(queue.tryPush(4));
+}
+
+TEST(SpscQueueTest, QueueShouldPassAllItemsInOrderBetweenThreads)
+{
+    SpscQueue<int> queue(16);
+    std::thread producer([&queue]
+    {
+        for(int i = 0; i < ITEMS_COUNT;)
+        {
+            if(queue.tryPush(int(i)))
+                ++i;
+            else
+                std::this_thread::yield();
+        }
+    });
+
+    int expected = 0;
+    bool isOrderKept = true;
+    while(expected < ITEMS_COUNT)
+    {
+        if(int item; queue.tryPop(item))
+            isOrderKept &= (item == expected++);
+        else
+            std::this_thread::yield();
+    }
+
+    producer.join();
+    ASSERT_TRUE(isOrderKept);
+    ASSERT_TRUE(queue.empty());
+}
+}
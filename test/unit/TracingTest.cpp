@@ -0,0 +1,60 @@
+#include <sstream>
+#include <thread>
+#include <gtest/gtest.h>
+#include "Tracing.hpp"
+
+using namespace testing;
+
+namespace AVMuxer::Test
+{
+namespace
+{
+size_t countOccurrences(const std::string& text, const std::string& pattern)
+{
+    size_t count = 0;
+    for(auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + pattern.size()))
+        ++count;
+
+    return count;
+}
+}
+
+TEST(TracingTest, RecordedSpansShouldBeDumpedAsChromeTraceEvents)
+{
+    Tracing::clear();
+    {
+        Tracing::ScopedSpan span("outerSpan");
+        Tracing::recordSpan("innerSpan", 1500, 2250);
+    }
+    std::thread([] { Tracing::ScopedSpan span("otherThreadSpan"); }).join();
+
+    std::ostringstream output;
+    Tracing::writeChromeTrace(output);
+    auto trace = output.str();
+    ASSERT_EQ(trace.rfind(R"({"displayTimeUnit":"ns","traceEvents":[)", 0), 0);
+    ASSERT_NE(trace.find(R"("name":"outerSpan","ph":"X")"), std::string::npos);
+    ASSERT_NE(trace.find(R"("name":"innerSpan","ph":"X","pid":1,"tid":)"), std::string::npos);
+    ASSERT_NE(trace.find(R"("ts":1.5,"dur":2.2})"), std::string::npos);
+    ASSERT_NE(trace.find(R"("name":"otherThreadSpan")"), std::string::npos);
+}
+
+TEST(TracingTest, RingBufferShouldKeepOnlyMostRecentSpans)
+{
+    Tracing::clear();
+    for(uint32_t i = 0; i < Tracing::RING_BUFFER_SIZE; ++i)
+        Tracing::recordSpan("oldSpan", i, 1);
+    for(uint32_t i = 0; i < Tracing::RING_BUFFER_SIZE / 2; ++i)
+        Tracing::recordSpan("newSpan", i, 1);
+
+    std::ostringstream output;
+    Tracing::writeChromeTrace(output);
+    auto trace = output.str();
+    ASSERT_EQ(countOccurrences(trace, R"("name":"oldSpan")"), Tracing::RING_BUFFER_SIZE / 2 - 1);
+    ASSERT_EQ(countOccurrences(trace, R"("name":"newSpan")"), Tracing::RING_BUFFER_SIZE / 2);
+
+    Tracing::clear();
+    std::ostringstream clearedOutput;
+    Tracing::writeChromeTrace(clearedOutput);
+    ASSERT_EQ(clearedOutput.str().find(R"("name":)"), std::string::npos);
+}
+}
@@ -0,0 +1,63 @@
+#include <climits>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include "BatchManifest.hpp"
+
+namespace AVMuxer::Tools
+{
+namespace
+{
+constexpr auto NO_AUDIO = "-";
+
+bool parsePositiveInt(const char* text, char** end, int& value)
+{
+    auto number = std::strtol(text, end, 10);
+    if(*end == text || number <= 0 || number > INT_MAX)
+        return false;
+
+    value = static_cast<int>(number);
+    return true;
+}
+}
+
+bool parseFramerate(const std::string& text, AVRational& framerate)
+{
+    char* end = nullptr;
+    framerate = { 0, 1 };
+    if(!parsePositiveInt(text.c_str(), &end, framerate.num))
+        return false;
+    if(*end == '/' && !parsePositiveInt(end + 1, &end, framerate.den))
+        return false;
+
+    return *end == '\0';
+}
+
+std::vector<BatchJob> readManifest(std::istream& manifest)
+{
+    std::vector<BatchJob> jobs;
+    std::string line;
+    for(unsigned lineNumber = 1; std::getline(manifest, line); ++lineNumber)
+    {
+        std::istringstream fields(line);
+        std::string framerate;
+        std::string excess;
+        BatchJob job;
+        if(!(fields >> job.videoPath) || job.videoPath[0] == '#')
+            continue;
+
+        if(!(fields >> job.audioPath >> framerate >> job.outputPath) || (fields >> excess)
+           || !parseFramerate(framerate, job.framerate))
+        {
+            throw std::invalid_argument("Invalid job at line " + std::to_string(lineNumber) + " of manifest: " + line);
+        }
+
+        if(job.audioPath == NO_AUDIO)
+            job.audioPath.clear();
+        jobs.push_back(std::move(job));
+    }
+
+    return jobs;
+}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+    #include <libavutil/avutil.h>
+}
+
+namespace AVMuxer::Tools
+{
+struct BatchJob
+{
+    std::string videoPath;
+    std::string audioPath;      //Empty for video-only job
+    AVRational  framerate;
+    std::string outputPath;
+};
+
+//Accepts whole number (ie. "25") or fraction (ie. "30000/1001"); returns false if it's not valid, positive framerate
+bool parseFramerate(const std::string& text, AVRational& framerate);
+
+//Manifest has one job per line: <video stream path> <audio stream path or -> <fps> <output file path>;
+//empty lines and lines starting with # are skipped. Throws std::invalid_argument telling which line is invalid
+std::vector<BatchJob> readManifest(std::istream& manifest);
+}
@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AVIOBufferPool.hpp"
+#include "BatchManifest.hpp"
+#include "FileSink.hpp"
+#include "MappedFile.hpp"
+#include "Muxer.hpp"
+
+extern "C"
+{
+    #include <libavutil/log.h>
+}
+
+namespace
+{
+constexpr double MEBIBYTE = 1024.0 * 1024.0;
+constexpr size_t OUTPUT_IO_BUFFER_SIZE = 64 * 1024;
+constexpr size_t INPUT_SLICE_SIZE = 4 * 1024 * 1024;
+
+struct BatchOptions
+{
+    std::string          manifestPath;
+    std::string          formatName = "mp4";
+    unsigned             threadsCount = std::max(1u, std::thread::hardware_concurrency());
+    AVMuxer::FsyncPolicy fsyncPolicy = AVMuxer::FsyncPolicy::NEVER;
+    bool                 isQuiet = false;
+};
+
+struct JobResult
+{
+    bool        isSuccessful = false;
+    std::string error;
+    uint64_t    inputBytes = 0;
+    uint64_t    outputBytes = 0;
+    uint64_t    packetsMuxed = 0;
+    double      seconds = 0;
+};
+
+void printUsage()
+{
+    std::cout << "Usage: avmux-batch [-j <threads count>] [-f <container format>] [--fsync] [-q] <manifest file path>\n"
+                 "Manifest has one job per line: <video stream path> <audio stream path or -> <fps> <output file path>;\n"
+                 "fps can be given as fraction (ie. 30000/1001), empty lines and lines starting with # are skipped" << std::endl;
+}
+
+bool parseOptions(int argc, char** argv, BatchOptions& options)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(arg == "-j" && i + 1 < argc)
+        {
+            int threadsCount = std::atoi(argv[++i]);
+            if(threadsCount <= 0)
+                return false;
+
+            options.threadsCount = threadsCount;
+        }
+        else if(arg == "-f" && i + 1 < argc)
+            options.formatName = argv[++i];
+        else if(arg == "--fsync")
+            options.fsyncPolicy = AVMuxer::FsyncPolicy::ON_CLOSE;
+        else if(arg == "-q")
+            options.isQuiet = true;
+        else if(options.manifestPath.empty() && arg[0] != '-')
+            options.manifestPath = arg;
+        else
+            return false;
+    }
+
+    return !options.manifestPath.empty();
+}
+
+//Stream's input is handed to muxer in slices of mapping, so it's read straight from page cache, and each slice's pages
+//are dropped once it's demuxed; input is finished with its last slice, so stream's last frame is muxed as well
+template <unsigned StreamNumber, unsigned StreamsCount>
+void muxInputSlice(AVMuxer::Muxer<StreamsCount>& muxer, const AVMuxer::MappedFile& input, size_t offset)
+{
+    if(offset >= input.size() && offset > 0)
+        return;
+
+    if(offset < input.size())
+        muxer.template muxMediaData<StreamNumber>(input.getData(offset, INPUT_SLICE_SIZE));
+    if(offset + INPUT_SLICE_SIZE >= input.size())
+        muxer.template finishInput<StreamNumber>();
+}
+
+//Streams are fed slice by slice in turns; since buffered input isn't copied, flushing until no more packets are muxed
+//lets muxer interleave what's left on its own. Finishing muxer then writes packets still waiting in interleaving
+//queue and container's trailer
+template <unsigned StreamsCount>
+uint64_t remux(AVMuxer::Muxer<StreamsCount>& muxer, const std::vector<std::shared_ptr<AVMuxer::MappedFile>>& inputs)
+{
+    auto maxInputSize = std::max_element(inputs.begin(), inputs.end(), [](const auto& first, const auto& second)
+    {
+        return first->size() < second->size();
+    })->get()->size();
+    for(size_t offset = 0; offset == 0 || offset < maxInputSize; offset += INPUT_SLICE_SIZE)
+    {
+        muxInputSlice<0>(muxer, *inputs[0], offset);
+        if constexpr(StreamsCount == 2)
+            muxInputSlice<1>(muxer, *inputs[1], offset);
+    }
+
+    uint64_t packetsMuxed = 0;
+    uint64_t previousPacketsMuxed = 0;
+    do
+    {
+        previousPacketsMuxed = packetsMuxed;
+        muxer.flush();
+        packetsMuxed = muxer.getMetrics().packetsMuxed;
+    } while(packetsMuxed != previousPacketsMuxed);
+
+    muxer.finish();
+    return muxer.getMetrics().packetsMuxed;
+}
+
+JobResult runJob(const AVMuxer::Tools::BatchJob& job, const BatchOptions& options)
+{
+    JobResult result;
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        std::vector<std::shared_ptr<AVMuxer::MappedFile>> inputs { AVMuxer::MappedFile::open(job.videoPath) };
+        if(!job.audioPath.empty())
+            inputs.push_back(AVMuxer::MappedFile::open(job.audioPath));
+
+        for(auto& input : inputs)
+            result.inputBytes += input->size();
+
+        AVMuxer::FileSinkOptions sinkOptions;
+        sinkOptions.fsyncPolicy = options.fsyncPolicy;
+        auto sink = std::make_shared<AVMuxer::FileSink>(job.outputPath, sinkOptions);
+        AVMuxer::MuxerMetrics metrics;
+        if(inputs.size() == 2)
+        {
+            AVMuxer::Muxer<2> muxer(options.formatName.c_str(), job.framerate, sink);
+            result.packetsMuxed = remux(muxer, inputs);
+            metrics = muxer.getMetrics();
+        }
+        else
+        {
+            AVMuxer::Muxer<1> muxer(options.formatName.c_str(), job.framerate, sink);
+            result.packetsMuxed = remux(muxer, inputs);
+            metrics = muxer.getMetrics();
+        }
+
+        result.outputBytes = metrics.outputBytes;
+        if(sink->flush(options.fsyncPolicy != AVMuxer::FsyncPolicy::NEVER) < 0)
+            result.error = "Could not write output file";
+        else if(result.packetsMuxed == 0)
+            result.error = "No packets were muxed";
+        else
+            result.isSuccessful = true;
+    }
+    catch(const std::exception& e)
+    {
+        result.error = e.what();
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+double getThroughput(uint64_t bytes, double seconds)
+{
+    return seconds > 0 ? bytes / MEBIBYTE / seconds : 0;
+}
+}
+
+//Remuxes elementary streams listed in manifest into containers, running jobs in parallel on worker threads;
+//reports each job's and aggregate throughput
+int main(int argc, char** argv)
+{
+    BatchOptions options;
+    if(!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<AVMuxer::Tools::BatchJob> jobs;
+    std::ifstream manifest(options.manifestPath);
+    if(!manifest.is_open())
+    {
+        std::cout << "Could not open manifest " << options.manifestPath << std::endl;
+        return 2;
+    }
+
+    try
+    {
+        jobs = AVMuxer::Tools::readManifest(manifest);
+    }
+    catch(const std::invalid_argument& e)
+    {
+        std::cout << e.what() << std::endl;
+        return 2;
+    }
+
+    av_log_set_level(AV_LOG_ERROR);
+    //Throughput matters here, not latency
+    AVMuxer::setDefaultIoBufferSize(AVMuxer::IoBufferRole::OUTPUT, OUTPUT_IO_BUFFER_SIZE);
+    std::vector<JobResult> results(jobs.size());
+    std::atomic<size_t> nextJob { 0 };
+    std::mutex outputMutex;
+    auto runJobs = [&]
+    {
+        for(auto i = nextJob.fetch_add(1, std::memory_order_relaxed); i < jobs.size(); i = nextJob.fetch_add(1, std::memory_order_relaxed))
+        {
+            results[i] = runJob(jobs[i], options);
+            if(options.isQuiet && results[i].isSuccessful)
+                continue;
+
+            auto& result = results[i];
+            std::lock_guard lock(outputMutex);
+            std::cout << (result.isSuccessful ? "[ok] " : "[failed] ") << jobs[i].outputPath << ": ";
+            if(result.isSuccessful)
+                std::cout << result.inputBytes / MEBIBYTE << " MiB in, " << result.outputBytes / MEBIBYTE << " MiB out, "
+                          << result.packetsMuxed << " packets, " << result.seconds << " s, "
+                          << getThroughput(result.inputBytes, result.seconds) << " MiB/s" << std::endl;
+            else
+                std::cout << result.error << std::endl;
+        }
+    };
+
+    std::cout << std::fixed << std::setprecision(3);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for(unsigned i = 1; i < std::min<size_t>(options.threadsCount, jobs.size()); ++i)
+        workers.emplace_back(runJobs);
+
+    runJobs();
+    for(auto& worker : workers)
+        worker.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t failedCount = 0;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    for(auto& result : results)
+    {
+        failedCount += !result.isSuccessful;
+        inputBytes += result.inputBytes;
+        outputBytes += result.outputBytes;
+    }
+
+    std::cout << jobs.size() << " jobs (" << failedCount << " failed) on " << std::max<size_t>(1, std::min<size_t>(options.threadsCount, jobs.size()))
+              << " threads: " << inputBytes / MEBIBYTE << " MiB in, " << outputBytes / MEBIBYTE << " MiB out, " << seconds << " s, "
+              << getThroughput(inputBytes, seconds) << " MiB/s, " << (seconds > 0 ? jobs.size() / seconds : 0) << " jobs/s" << std::endl;
+    return failedCount == 0 ? 0 : 1;
+}